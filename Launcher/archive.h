@@ -0,0 +1,455 @@
+// header for reading and validating the structure of Relic SGA archives without touching their payload, and for building synthetic archives to test and benchmark that on
+
+#pragma once
+
+#define SGA_HEADER_SIZE_V4 180 // size of the fixed file header of version 4 archives, the data header follows it directly
+#define SGA_HEADER_SIZE_V5 184 // size of the fixed file header of version 5 archives, which also stores the data header position
+#define SGA_DATA_HEADER_SIZE 24 // size of the four offset and count pairs at the start of the data header
+#define SGA_TOC_ENTRY_SIZE 138 // size of a table of contents entry, alias, start name and five indices
+#define SGA_FOLDER_ENTRY_SIZE 12 // size of a folder entry, name offset and four indices
+#define SGA_FILE_ENTRY_SIZE_V4 20 // size of a version 4 file entry
+#define SGA_FILE_ENTRY_SIZE_V5 22 // size of a version 5 file entry, which adds a modification time and narrows the flags
+#define SGA_PREAMBLE_NAME_SIZE 256 // size of the file name field of the preamble stored in front of each file's data
+#define SGA_PREAMBLE_SIZE 264 // size of the version 5 preamble, file name, modification time and CRC-32 of the stored data
+#define SGA_HEADER_MAP_SIZE (16 * 1024 * 1024) // size of the prefix mapped to read the header, larger tables of contents are remapped to fit
+#define SGA_VERIFY_CHUNK_SIZE (8 * 1024 * 1024) // size of the chunks archive contents are split into for parallel verification
+
+// standard library headers
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+// launcher headers
+#include "trace.h"
+#include "hashing.h"
+
+// structure to hold a table in the data header of an SGA archive
+struct SgaTable
+{
+    uint32_t offset = 0; // relative to the start of the data header
+    uint16_t count = 0;
+};
+
+// structure to hold the parsed header of an SGA archive
+struct SgaArchiveInfo
+{
+    uint16_t versionMajor = 0;
+    uint16_t versionMinor = 0;
+    uint64_t dataHeaderOffset = 0;
+    uint32_t dataHeaderSize = 0;
+    uint64_t dataOffset = 0;
+    SgaTable tocTable;
+    SgaTable folderTable;
+    SgaTable fileTable;
+    SgaTable stringTable;
+    bool knownLayout = false; // false for versions whose layout is unknown, only their magic is validated
+};
+
+// levels of archive verification performed by the module check
+enum class SgaVerificationLevel
+{
+    None, // only the existence of the archives is checked
+    Header, // the header and table of contents are validated, the payload is never read
+    Full // every file's stored data is also checked against the CRC-32 in its preamble
+};
+
+// structure to hold a file entry of an SGA archive
+struct SgaFileEntry
+{
+    uint32_t nameOffset = 0;
+    uint64_t dataOffset = 0; // absolute position of the stored data in the archive
+    uint32_t compressedSize = 0;
+    uint32_t decompressedSize = 0;
+};
+
+// function to parse a verification level from its launch configuration name
+bool ParseSgaVerificationLevel(const std::wstring& value, SgaVerificationLevel& level)
+{
+    if (value == L"none")
+    {
+        level = SgaVerificationLevel::None;
+    }
+    else if (value == L"header")
+    {
+        level = SgaVerificationLevel::Header;
+    }
+    else if (value == L"full")
+    {
+        level = SgaVerificationLevel::Full;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+// function to get the launch configuration name of a verification level
+const wchar_t* GetSgaVerificationLevelName(SgaVerificationLevel level)
+{
+    switch (level)
+    {
+    case SgaVerificationLevel::None:
+        return L"none";
+    case SgaVerificationLevel::Full:
+        return L"full";
+    default:
+        return L"header";
+    }
+}
+
+// function to read a little endian 16-bit value
+uint16_t ReadLittleEndian16(const unsigned char* data)
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+// function to check that a range lies within a buffer, without overflowing
+bool RangeFits(uint64_t offset, uint64_t length, uint64_t size)
+{
+    return offset <= size && length <= size - offset;
+}
+
+// function to parse the fixed header of a mapped SGA archive and check that its data header and data section lie within the file
+bool ReadSgaFixedHeader(const MappedFile& archive, SgaArchiveInfo& info, std::wstring& problem)
+{
+    const unsigned char* data = archive.data;
+
+    if (archive.size < 12 || memcmp(data, "_ARCHIVE", 8) != 0)
+    {
+        problem = L"not an SGA archive";
+        return false;
+    }
+
+    info.versionMajor = ReadLittleEndian16(data + 8);
+    info.versionMinor = ReadLittleEndian16(data + 10);
+    if (info.versionMajor != 4 && info.versionMajor != 5)
+    {
+        // other games use other layouts, so an unknown version is accepted rather than guessed at
+        info.knownLayout = false;
+        return true;
+    }
+    info.knownLayout = true;
+
+    size_t fixedHeaderSize = (info.versionMajor == 5) ? SGA_HEADER_SIZE_V5 : SGA_HEADER_SIZE_V4;
+    if (archive.size < fixedHeaderSize)
+    {
+        problem = L"truncated header";
+        return false;
+    }
+
+    info.dataHeaderSize = ReadLittleEndian32(data + 172);
+    info.dataOffset = ReadLittleEndian32(data + 176);
+    info.dataHeaderOffset = (info.versionMajor == 5) ? ReadLittleEndian32(data + 180) : SGA_HEADER_SIZE_V4;
+
+    if (info.dataHeaderSize < SGA_DATA_HEADER_SIZE || !RangeFits(info.dataHeaderOffset, info.dataHeaderSize, archive.fileSize))
+    {
+        problem = L"table of contents extends beyond the end of the file";
+        return false;
+    }
+    if (info.dataOffset > archive.fileSize)
+    {
+        problem = L"data section starts beyond the end of the file";
+        return false;
+    }
+    return true;
+}
+
+// function to parse the data header of a mapped SGA archive and check that its tables lie within it, the view has to cover the data header
+bool ReadSgaDataHeader(const MappedFile& archive, SgaArchiveInfo& info, std::wstring& problem)
+{
+    if (!RangeFits(info.dataHeaderOffset, info.dataHeaderSize, archive.size))
+    {
+        problem = L"table of contents extends beyond the end of the file";
+        return false;
+    }
+
+    const unsigned char* dataHeader = archive.data + info.dataHeaderOffset;
+    SgaTable* tables[4] = { &info.tocTable, &info.folderTable, &info.fileTable, &info.stringTable };
+    for (size_t i = 0; i < 4; ++i)
+    {
+        tables[i]->offset = ReadLittleEndian32(dataHeader + i * 6);
+        tables[i]->count = ReadLittleEndian16(dataHeader + i * 6 + 4);
+    }
+
+    size_t fileEntrySize = (info.versionMajor == 5) ? SGA_FILE_ENTRY_SIZE_V5 : SGA_FILE_ENTRY_SIZE_V4;
+    if (!RangeFits(info.tocTable.offset, static_cast<uint64_t>(info.tocTable.count) * SGA_TOC_ENTRY_SIZE, info.dataHeaderSize) ||
+        !RangeFits(info.folderTable.offset, static_cast<uint64_t>(info.folderTable.count) * SGA_FOLDER_ENTRY_SIZE, info.dataHeaderSize) ||
+        !RangeFits(info.fileTable.offset, static_cast<uint64_t>(info.fileTable.count) * fileEntrySize, info.dataHeaderSize) ||
+        info.stringTable.offset > info.dataHeaderSize)
+    {
+        problem = L"corrupt table of contents";
+        return false;
+    }
+    return true;
+}
+
+// function to map the header region of an SGA archive and parse it, the payload is never mapped
+bool MapSgaArchiveHeader(const wchar_t* filepath, MappedFile& archive, SgaArchiveInfo& info, std::wstring& problem)
+{
+    if (!MapPortableFile(filepath, archive, SGA_HEADER_MAP_SIZE))
+    {
+        problem = L"the file could not be opened";
+        return false;
+    }
+    if (!ReadSgaFixedHeader(archive, info, problem))
+    {
+        UnmapPortableFile(archive);
+        return false;
+    }
+    if (!info.knownLayout)
+    {
+        return true;
+    }
+
+    // unusually large tables of contents get a view of exactly the header region
+    uint64_t headerEnd = info.dataHeaderOffset + info.dataHeaderSize;
+    if (headerEnd > archive.size)
+    {
+        UnmapPortableFile(archive);
+        if (!MapPortableFile(filepath, archive, static_cast<size_t>(headerEnd)))
+        {
+            problem = L"the file could not be opened";
+            return false;
+        }
+    }
+
+    if (!ReadSgaDataHeader(archive, info, problem))
+    {
+        UnmapPortableFile(archive);
+        return false;
+    }
+    return true;
+}
+
+// function to read a file entry from the table of contents of a mapped SGA archive whose header has been validated
+void GetSgaFileEntry(const MappedFile& archive, const SgaArchiveInfo& info, size_t index, SgaFileEntry& entry)
+{
+    size_t fileEntrySize = (info.versionMajor == 5) ? SGA_FILE_ENTRY_SIZE_V5 : SGA_FILE_ENTRY_SIZE_V4;
+    const unsigned char* record = archive.data + info.dataHeaderOffset + info.fileTable.offset + index * fileEntrySize;
+
+    entry.nameOffset = ReadLittleEndian32(record);
+    if (info.versionMajor == 5)
+    {
+        entry.dataOffset = info.dataOffset + ReadLittleEndian32(record + 4);
+        entry.compressedSize = ReadLittleEndian32(record + 8);
+        entry.decompressedSize = ReadLittleEndian32(record + 12);
+    }
+    else
+    {
+        entry.dataOffset = info.dataOffset + ReadLittleEndian32(record + 8);
+        entry.compressedSize = ReadLittleEndian32(record + 12);
+        entry.decompressedSize = ReadLittleEndian32(record + 16);
+    }
+}
+
+// function to read the name of a file entry from the string table, false if the name runs past the end of the data header
+bool GetSgaFileName(const MappedFile& archive, const SgaArchiveInfo& info, const SgaFileEntry& entry, std::string& name)
+{
+    uint64_t position = info.dataHeaderOffset + info.stringTable.offset + static_cast<uint64_t>(entry.nameOffset);
+    uint64_t headerEnd = info.dataHeaderOffset + info.dataHeaderSize;
+    if (position >= headerEnd)
+    {
+        return false;
+    }
+
+    const char* begin = reinterpret_cast<const char*>(archive.data + position);
+    const void* terminator = memchr(begin, '\0', static_cast<size_t>(headerEnd - position));
+    if (terminator == nullptr)
+    {
+        return false;
+    }
+    name.assign(begin, static_cast<const char*>(terminator));
+    return true;
+}
+
+// function to check that the preamble stored in front of a file's data names that file, and to read the checksum it holds
+bool ReadSgaFilePreamble(const unsigned char* preamble, const std::string& name, uint32_t& crc)
+{
+    // a preamble that does not hold the expected name belongs to a layout this code does not know, it is not treated as damage
+    const char* storedName = reinterpret_cast<const char*>(preamble);
+    const void* terminator = memchr(storedName, '\0', SGA_PREAMBLE_NAME_SIZE);
+    size_t storedLength = terminator != nullptr ? static_cast<size_t>(static_cast<const char*>(terminator) - storedName) : SGA_PREAMBLE_NAME_SIZE;
+    if (storedLength != name.size() || memcmp(storedName, name.data(), storedLength) != 0)
+    {
+        return false;
+    }
+
+    crc = ReadLittleEndian32(preamble + SGA_PREAMBLE_NAME_SIZE + 4);
+    return true;
+}
+
+// function to calculate the XXH64 digest of the header region of a mapped SGA archive, which changes whenever its table of contents does
+std::string CalculateSgaHeaderDigest(const MappedFile& archive, const SgaArchiveInfo& info)
+{
+    uint64_t headerEnd = info.knownLayout ? info.dataHeaderOffset + info.dataHeaderSize : SGA_HEADER_SIZE_V5;
+    size_t digestSize = static_cast<size_t>((std::min)(headerEnd, static_cast<uint64_t>(archive.size)));
+    return CalculateBufferHash(archive.data, digestSize, HashAlgorithm::XXH64);
+}
+
+// function to validate the header, table of contents and file data ranges of an SGA archive, reading only the header region, the digest of a valid header is returned
+bool ValidateSgaArchive(const wchar_t* filepath, std::wstring& problem, std::string& headerDigest)
+{
+    TRACE_SCOPE("ValidateSgaArchive", filepath);
+    MappedFile archive;
+    SgaArchiveInfo info;
+    if (!MapSgaArchiveHeader(filepath, archive, info, problem))
+    {
+        return false;
+    }
+
+    bool valid = true;
+    if (info.knownLayout)
+    {
+        // folder indices have to stay within the file and folder tables
+        for (size_t i = 0; i < info.folderTable.count && valid; ++i)
+        {
+            const unsigned char* record = archive.data + info.dataHeaderOffset + info.folderTable.offset + i * SGA_FOLDER_ENTRY_SIZE;
+            if (ReadLittleEndian16(record + 6) > info.folderTable.count || ReadLittleEndian16(record + 10) > info.fileTable.count)
+            {
+                problem = L"corrupt folder table";
+                valid = false;
+            }
+        }
+
+        // the stored data of every file has to lie within the archive
+        for (size_t i = 0; i < info.fileTable.count && valid; ++i)
+        {
+            SgaFileEntry entry;
+            GetSgaFileEntry(archive, info, i, entry);
+            if (!RangeFits(entry.dataOffset, entry.compressedSize, archive.fileSize))
+            {
+                problem = L"file data extends beyond the end of the archive, it is likely truncated";
+                valid = false;
+            }
+        }
+    }
+
+    if (valid)
+    {
+        headerDigest = CalculateSgaHeaderDigest(archive, info);
+    }
+
+    UnmapPortableFile(archive);
+    return valid;
+}
+
+// function to fill a buffer with deterministic data that does not compress, so that reading it costs what reading real archive data does
+void FillDeterministicData(char* data, size_t size, uint64_t seed)
+{
+    uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (i % 8 == 0)
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+        }
+        data[i] = static_cast<char>((state * 0x2545F4914F6CDD1DULL) >> ((i % 8) * 8));
+    }
+}
+
+// function to write a little endian 16-bit value into a buffer
+void WriteLittleEndian16(std::string& buffer, size_t offset, uint16_t value)
+{
+    buffer[offset] = static_cast<char>(value & 0xFF);
+    buffer[offset + 1] = static_cast<char>(value >> 8);
+}
+
+// function to write a little endian 32-bit value into a buffer
+void WriteLittleEndian32(std::string& buffer, size_t offset, uint32_t value)
+{
+    for (size_t i = 0; i < 4; ++i)
+    {
+        buffer[offset + i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+    }
+}
+
+// function to build a version 5 SGA archive of about the requested size in memory, with one folder of files whose preambles hold valid checksums
+std::string BuildSgaArchive(const char* archiveName, unsigned long long archiveSize, unsigned int fileCount, uint64_t seed)
+{
+    fileCount = (std::max)(1u, (std::min)(fileCount, 0xFFFFu));
+
+    std::vector<std::string> fileNames;
+    std::string stringTable(1, '\0'); // the folder name is empty
+    std::vector<uint32_t> nameOffsets;
+    for (unsigned int i = 0; i < fileCount; ++i)
+    {
+        fileNames.push_back("file" + std::to_string(i) + ".dat");
+        nameOffsets.push_back(static_cast<uint32_t>(stringTable.size()));
+        stringTable += fileNames.back();
+        stringTable += '\0';
+    }
+
+    // the table of contents, folder table, file table and string table follow the data header in that order
+    uint32_t tocOffset = SGA_DATA_HEADER_SIZE;
+    uint32_t folderOffset = tocOffset + SGA_TOC_ENTRY_SIZE;
+    uint32_t fileOffset = folderOffset + SGA_FOLDER_ENTRY_SIZE;
+    uint32_t stringOffset = fileOffset + fileCount * SGA_FILE_ENTRY_SIZE_V5;
+    uint32_t dataHeaderSize = stringOffset + static_cast<uint32_t>(stringTable.size());
+    uint32_t dataOffset = SGA_HEADER_SIZE_V5 + dataHeaderSize;
+
+    unsigned long long payload = archiveSize > dataOffset ? archiveSize - dataOffset : 0;
+    size_t fileSize = static_cast<size_t>((std::max)(1ULL, payload / fileCount > SGA_PREAMBLE_SIZE ? payload / fileCount - SGA_PREAMBLE_SIZE : 1ULL));
+
+    std::string archive(dataOffset + static_cast<size_t>(fileCount) * (SGA_PREAMBLE_SIZE + fileSize), '\0');
+    memcpy(&archive[0], "_ARCHIVE", 8);
+    WriteLittleEndian16(archive, 8, 5);
+    WriteLittleEndian16(archive, 10, 0);
+    for (size_t i = 0; archiveName[i] != '\0'; ++i)
+    {
+        archive[28 + i * 2] = archiveName[i]; // the archive name is UTF-16
+    }
+    WriteLittleEndian32(archive, 172, dataHeaderSize);
+    WriteLittleEndian32(archive, 176, dataOffset);
+    WriteLittleEndian32(archive, 180, SGA_HEADER_SIZE_V5);
+
+    size_t dataHeader = SGA_HEADER_SIZE_V5;
+    uint32_t tableOffsets[4] = { tocOffset, folderOffset, fileOffset, stringOffset };
+    uint16_t tableCounts[4] = { 1, 1, static_cast<uint16_t>(fileCount), static_cast<uint16_t>(fileCount + 1) };
+    for (size_t i = 0; i < 4; ++i)
+    {
+        WriteLittleEndian32(archive, dataHeader + i * 6, tableOffsets[i]);
+        WriteLittleEndian16(archive, dataHeader + i * 6 + 4, tableCounts[i]);
+    }
+
+    // the table of contents holds an alias and a name, then the folder and file ranges it covers
+    memcpy(&archive[dataHeader + tocOffset], "data", 4);
+    memcpy(&archive[dataHeader + tocOffset + 64], "data", 4);
+    WriteLittleEndian16(archive, dataHeader + tocOffset + 128, 0);
+    WriteLittleEndian16(archive, dataHeader + tocOffset + 130, 1);
+    WriteLittleEndian16(archive, dataHeader + tocOffset + 132, 0);
+    WriteLittleEndian16(archive, dataHeader + tocOffset + 134, static_cast<uint16_t>(fileCount));
+
+    // the single folder has no subfolders and holds every file
+    WriteLittleEndian32(archive, dataHeader + folderOffset, 0);
+    WriteLittleEndian16(archive, dataHeader + folderOffset + 4, 1);
+    WriteLittleEndian16(archive, dataHeader + folderOffset + 6, 1);
+    WriteLittleEndian16(archive, dataHeader + folderOffset + 8, 0);
+    WriteLittleEndian16(archive, dataHeader + folderOffset + 10, static_cast<uint16_t>(fileCount));
+
+    memcpy(&archive[dataHeader + stringOffset], stringTable.data(), stringTable.size());
+
+    size_t position = dataOffset;
+    for (unsigned int i = 0; i < fileCount; ++i)
+    {
+        char* data = &archive[position + SGA_PREAMBLE_SIZE];
+        FillDeterministicData(data, fileSize, seed * 0x10000 + i);
+
+        memcpy(&archive[position], fileNames[i].data(), fileNames[i].size());
+        WriteLittleEndian32(archive, position + SGA_PREAMBLE_NAME_SIZE + 4, UpdateCRC32(0, data, fileSize));
+
+        size_t record = dataHeader + fileOffset + i * SGA_FILE_ENTRY_SIZE_V5;
+        WriteLittleEndian32(archive, record, nameOffsets[i]);
+        WriteLittleEndian32(archive, record + 4, static_cast<uint32_t>(position + SGA_PREAMBLE_SIZE - dataOffset));
+        WriteLittleEndian32(archive, record + 8, static_cast<uint32_t>(fileSize));
+        WriteLittleEndian32(archive, record + 12, static_cast<uint32_t>(fileSize));
+
+        position += SGA_PREAMBLE_SIZE + fileSize;
+    }
+
+    return archive;
+}
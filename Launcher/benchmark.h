@@ -0,0 +1,638 @@
+// header for generating a synthetic mod tree and measuring the launcher's validation pipelines on it, used by -benchmark
+// only included in the Benchmark configuration, which defines LAUNCHER_BENCHMARK, as it replaces the global allocation functions to count allocations
+
+#pragma once
+
+#define BENCHMARK_ARCHIVE_COUNT 24 // archives listed in the generated .module file, not counting one archive per locale
+#define BENCHMARK_ARCHIVE_SIZE_MIB 8 // default size of each generated archive, changed with -benchmarksize
+#define BENCHMARK_ARCHIVE_FILES 64 // files stored in each generated archive
+#define BENCHMARK_UCS_ENTRIES 40000 // entries in each generated UCS file, a few megabytes like the larger files of released mods
+#define BENCHMARK_ADDITIONAL_FILES 8 // file and .bin baseline pairs listed in [AdditionalFiles]
+#define BENCHMARK_ADDITIONAL_FILE_SIZE (4 * 1024 * 1024) // size of each additional file and of its baseline
+#define BENCHMARK_CONFIG_READS 200 // reads of the launch configuration per measurement, a single read is too short to time
+#define BENCHMARK_MODULE_CHECKS 50 // passes of the line break check over the .module copies per measurement, for the same reason
+
+// standard library headers
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <algorithm>
+
+// boost headers
+#include <boost/predef/os.h>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/locale/encoding_utf.hpp>
+
+// launcher headers
+#include "trace.h"
+#include "hashing.h"
+#include "textscan.h"
+#include "archive.h"
+
+// platform headers
+#if BOOST_OS_WINDOWS
+#include <windows.h>
+#include <psapi.h>
+#include <malloc.h>
+#endif
+
+// global allocation counters, every allocation of the benchmark build goes through the replaced operator new below
+std::atomic<unsigned long long> benchmarkAllocations{ 0 };
+std::atomic<unsigned long long> benchmarkAllocatedBytes{ 0 };
+
+// replaced global allocation functions, counting the allocations the measured pipelines make
+// every form a compiler may call is replaced, so no memory from std::malloc reaches a deallocation function of the runtime, the nothrow forms forward to these
+void* operator new(size_t size)
+{
+    benchmarkAllocations.fetch_add(1, std::memory_order_relaxed);
+    benchmarkAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    void* memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    operator delete(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    operator delete(memory);
+}
+
+// over-aligned types only allocate through these in C++17 and later, the Windows heap frees aligned blocks with its own function
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    benchmarkAllocations.fetch_add(1, std::memory_order_relaxed);
+    benchmarkAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+#if BOOST_OS_WINDOWS
+    void* memory = _aligned_malloc(size == 0 ? 1 : size, static_cast<size_t>(alignment));
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, (std::max)(static_cast<size_t>(alignment), sizeof(void*)), size == 0 ? 1 : size) != 0)
+    {
+        memory = nullptr;
+    }
+#endif
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+#if BOOST_OS_WINDOWS
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+void operator delete[](void* memory, std::align_val_t alignment) noexcept
+{
+    operator delete(memory, alignment);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(memory, alignment);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(memory, alignment);
+}
+#endif
+
+// text encodings and line breaks the generated UCS files are written in, covering every variant the UCS check has to handle
+enum class BenchmarkTextVariant
+{
+    UTF16LE_CRLF, // already in the format the game requires, validated without conversion
+    UTF16LE_LF,
+    UTF16BE_CRLF,
+    UTF16BE_LF,
+    UTF8BOM_CRLF,
+    UTF8BOM_LF,
+    UTF8_CRLF,
+    UTF8_LF
+};
+
+const BenchmarkTextVariant BENCHMARK_TEXT_VARIANTS[] = { BenchmarkTextVariant::UTF16LE_CRLF, BenchmarkTextVariant::UTF16LE_LF, BenchmarkTextVariant::UTF16BE_CRLF, BenchmarkTextVariant::UTF16BE_LF,
+    BenchmarkTextVariant::UTF8BOM_CRLF, BenchmarkTextVariant::UTF8BOM_LF, BenchmarkTextVariant::UTF8_CRLF, BenchmarkTextVariant::UTF8_LF };
+
+// structure to hold a locale of the generated mod tree, with a sample of text in its language so that UTF-8 files hold multibyte sequences
+struct BenchmarkLocale
+{
+    const char* folderName;
+    const char16_t* sampleText;
+};
+
+const BenchmarkLocale BENCHMARK_LOCALES[] =
+{
+    { "English", u"Space Marine Scout squad" },
+    { "French", u"Escouade d'éclaireurs Space Marines" },
+    { "German", u"Spähertrupp der Space Marines für Überfälle" },
+    { "Russian", u"Отряд разведчиков Космодесанта" }
+};
+
+// structure to hold the size of the generated mod tree, the defaults resemble a large released mod
+struct BenchmarkOptions
+{
+    unsigned int archiveCount = BENCHMARK_ARCHIVE_COUNT;
+    unsigned long long archiveSize = BENCHMARK_ARCHIVE_SIZE_MIB * 1024ULL * 1024ULL;
+    unsigned int archiveFiles = BENCHMARK_ARCHIVE_FILES;
+    unsigned int ucsEntries = BENCHMARK_UCS_ENTRIES;
+    unsigned int additionalFiles = BENCHMARK_ADDITIONAL_FILES;
+    unsigned long long additionalFileSize = BENCHMARK_ADDITIONAL_FILE_SIZE;
+};
+
+// structure to hold the generated mod tree, paths inside it are relative to its root as they are next to the game
+struct BenchmarkFixture
+{
+    std::wstring rootDir; // absolute
+    std::wstring modName;
+    std::wstring moduleFileName;
+    std::wstring configFilePath;
+    unsigned int archives = 0; // archives the module check has to validate, the locale archives are skipped when several locales are present
+    unsigned long long archiveBytes = 0;
+    unsigned long long ucsBytes = 0;
+    unsigned int ucsFiles = 0; // without the DOW2.ucs files, which the UCS check skips
+    unsigned long long additionalBytes = 0; // files and their baselines together
+    unsigned long long configBytes = 0;
+    std::vector<std::wstring> ucsCopies; // copies of the UCS files outside the locale folders, as the line break check converts them in place
+    std::vector<std::wstring> moduleCopies; // the .module file in every encoding and line break variant
+    unsigned long long moduleCopyBytes = 0;
+};
+
+// function to write a generated file in one piece
+bool WriteBenchmarkFile(const boost::filesystem::path& path, const std::string& content)
+{
+    boost::filesystem::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    file.close();
+    return !file.fail();
+}
+
+// function to generate a version 5 SGA archive of about the requested size, with one folder of files whose preambles hold valid checksums
+bool WriteBenchmarkArchive(const boost::filesystem::path& path, unsigned long long archiveSize, unsigned int fileCount, uint64_t seed)
+{
+    return WriteBenchmarkFile(path, BuildSgaArchive("Benchmark", archiveSize, fileCount, seed));
+}
+
+// function to encode UTF-16 text as a UCS file would be stored in the given variant
+std::string EncodeBenchmarkText(const std::u16string& text, BenchmarkTextVariant variant)
+{
+    std::u16string content;
+    bool crlf = variant == BenchmarkTextVariant::UTF16LE_CRLF || variant == BenchmarkTextVariant::UTF16BE_CRLF ||
+        variant == BenchmarkTextVariant::UTF8BOM_CRLF || variant == BenchmarkTextVariant::UTF8_CRLF;
+    content.reserve(text.size() * 2);
+    for (char16_t c : text)
+    {
+        if (c == u'\n' && crlf)
+        {
+            content += u'\r';
+        }
+        content += c;
+    }
+
+    std::string encoded;
+    switch (variant)
+    {
+    case BenchmarkTextVariant::UTF16LE_CRLF:
+    case BenchmarkTextVariant::UTF16LE_LF:
+    case BenchmarkTextVariant::UTF16BE_CRLF:
+    case BenchmarkTextVariant::UTF16BE_LF:
+    {
+        bool bigEndian = variant == BenchmarkTextVariant::UTF16BE_CRLF || variant == BenchmarkTextVariant::UTF16BE_LF;
+        encoded.reserve(2 + content.size() * 2);
+        encoded += bigEndian ? "\xFE\xFF" : "\xFF\xFE";
+        for (char16_t c : content)
+        {
+            char low = static_cast<char>(c & 0xFF);
+            char high = static_cast<char>(c >> 8);
+            encoded += bigEndian ? high : low;
+            encoded += bigEndian ? low : high;
+        }
+    }
+    break;
+
+    case BenchmarkTextVariant::UTF8BOM_CRLF:
+    case BenchmarkTextVariant::UTF8BOM_LF:
+        encoded = "\xEF\xBB\xBF" + boost::locale::conv::utf_to_utf<char>(content);
+        break;
+
+    default:
+        encoded = boost::locale::conv::utf_to_utf<char>(content);
+        break;
+    }
+    return encoded;
+}
+
+// function to get the file name a UCS file of the given variant is generated under
+std::string GetBenchmarkTextVariantName(BenchmarkTextVariant variant)
+{
+    switch (variant)
+    {
+    case BenchmarkTextVariant::UTF16LE_CRLF:
+        return "UTF16LE_CRLF";
+    case BenchmarkTextVariant::UTF16LE_LF:
+        return "UTF16LE_LF";
+    case BenchmarkTextVariant::UTF16BE_CRLF:
+        return "UTF16BE_CRLF";
+    case BenchmarkTextVariant::UTF16BE_LF:
+        return "UTF16BE_LF";
+    case BenchmarkTextVariant::UTF8BOM_CRLF:
+        return "UTF8BOM_CRLF";
+    case BenchmarkTextVariant::UTF8BOM_LF:
+        return "UTF8BOM_LF";
+    case BenchmarkTextVariant::UTF8_CRLF:
+        return "UTF8_CRLF";
+    default:
+        return "UTF8_LF";
+    }
+}
+
+// function to build the entries of a generated UCS file, keys start at firstKey and are consecutive so the file has no gaps
+std::u16string BuildBenchmarkUcsText(const BenchmarkLocale& locale, unsigned int firstKey, unsigned int entries)
+{
+    std::u16string text;
+    std::u16string sample(locale.sampleText);
+    text.reserve(static_cast<size_t>(entries) * (sample.size() + 20));
+    for (unsigned int i = 0; i < entries; ++i)
+    {
+        std::string key = std::to_string(firstKey + i);
+        std::string suffix = " " + std::to_string(i);
+        text.append(key.begin(), key.end());
+        text += u'\t';
+        text += sample;
+        text.append(suffix.begin(), suffix.end());
+        text += u'\n';
+    }
+    return text;
+}
+
+// function to generate a mod tree in an empty directory, or in place of a tree generated there before: the .module file with its archives,
+// the locale folders with UCS files in every encoding and line break variant, the additional files with their .bin baselines, and the launch configuration
+bool GenerateBenchmarkFixture(const std::wstring& directory, const BenchmarkOptions& options, BenchmarkFixture& fixture)
+{
+    TRACE_SCOPE("GenerateBenchmarkFixture", directory);
+    boost::system::error_code ec;
+    boost::filesystem::path root = boost::filesystem::absolute(boost::filesystem::path(directory), ec);
+    if (ec)
+    {
+        return false;
+    }
+
+    fixture = BenchmarkFixture();
+    fixture.rootDir = root.wstring();
+    fixture.modName = L"Benchmark";
+    fixture.moduleFileName = fixture.modName + L".module";
+    fixture.configFilePath = (root / (fixture.modName + L".launchconfig")).wstring();
+
+    // a tree is only cleared if the benchmark generated it, so pointing -benchmark at a game directory cannot delete its files
+    bool generatedBefore = boost::filesystem::exists(root / fixture.moduleFileName, ec);
+    if (!generatedBefore && (boost::filesystem::exists(root / "GameAssets", ec) || boost::filesystem::exists(root / "Bin", ec)))
+    {
+        return false;
+    }
+    boost::filesystem::remove_all(root / "GameAssets", ec);
+    boost::filesystem::remove_all(root / "Bin", ec);
+    boost::filesystem::remove_all(root / "Text", ec);
+
+    boost::system::error_code archivesError;
+    boost::system::error_code binError;
+    boost::system::error_code textError;
+    boost::filesystem::create_directories(root / "GameAssets" / "Archives", archivesError);
+    boost::filesystem::create_directories(root / "Bin", binError);
+    boost::filesystem::create_directories(root / "Text", textError);
+    if (archivesError || binError || textError)
+    {
+        return false;
+    }
+
+    // the module lists the common archives first, then one archive per locale, with the paths written as they are next to the game
+    std::string module = "[global]\r\nUIName = Benchmark\r\nName = Benchmark\r\nDescription = Generated by the launcher benchmark\r\nModFolder = Benchmark\r\n\r\n[data:common]\r\n";
+    for (unsigned int i = 0; i < options.archiveCount; ++i)
+    {
+        std::string archiveName = "Benchmark" + std::to_string(i + 1) + ".sga";
+        if (!WriteBenchmarkArchive(root / "GameAssets" / "Archives" / archiveName, options.archiveSize, options.archiveFiles, i + 1))
+        {
+            return false;
+        }
+        module += "archive." + std::string(i < 9 ? "0" : "") + std::to_string(i + 1) + " = GameAssets\\Archives\\" + archiveName + "\r\n";
+        fixture.archiveBytes += boost::filesystem::file_size(root / "GameAssets" / "Archives" / archiveName, ec);
+        fixture.archives++;
+    }
+
+    unsigned int archiveIndex = options.archiveCount;
+    for (const auto& locale : BENCHMARK_LOCALES)
+    {
+        boost::filesystem::path localeDir = root / "GameAssets" / "Locale" / locale.folderName;
+        boost::filesystem::create_directories(localeDir, ec);
+        if (ec)
+        {
+            return false;
+        }
+
+        std::string archiveName = std::string("Benchmark") + locale.folderName + ".sga";
+        if (!WriteBenchmarkArchive(localeDir / archiveName, options.archiveSize / 8, options.archiveFiles, ++archiveIndex))
+        {
+            return false;
+        }
+        module += "\r\n[data:" + std::string(locale.folderName) + "]\r\narchive." + std::to_string(archiveIndex) + " = GameAssets\\Locale\\" + locale.folderName + "\\" + archiveName + "\r\n";
+
+        // DOW2.ucs marks the folder as a language the game has installed, it is not part of the UCS check
+        if (!WriteBenchmarkFile(localeDir / "DOW2.ucs", EncodeBenchmarkText(BuildBenchmarkUcsText(locale, 1, 100), BenchmarkTextVariant::UTF16LE_CRLF)))
+        {
+            return false;
+        }
+
+        // every variant gets its own key range, so the files of a locale do not collide
+        unsigned int firstKey = 1000000;
+        for (BenchmarkTextVariant variant : BENCHMARK_TEXT_VARIANTS)
+        {
+            std::string content = EncodeBenchmarkText(BuildBenchmarkUcsText(locale, firstKey, options.ucsEntries), variant);
+            boost::filesystem::path ucsCopy = root / "Text" / (std::string(locale.folderName) + "_" + GetBenchmarkTextVariantName(variant) + ".ucs");
+            if (!WriteBenchmarkFile(localeDir / ("Benchmark_" + GetBenchmarkTextVariantName(variant) + ".ucs"), content) || !WriteBenchmarkFile(ucsCopy, content))
+            {
+                return false;
+            }
+            fixture.ucsCopies.push_back(ucsCopy.wstring());
+            fixture.ucsBytes += content.size();
+            fixture.ucsFiles++;
+            firstKey += options.ucsEntries;
+        }
+    }
+
+    if (!WriteBenchmarkFile(root / fixture.moduleFileName, module))
+    {
+        return false;
+    }
+
+    // the module text is plain ASCII, so it is widened directly and stored with bare line breaks for the variants to add theirs
+    std::u16string moduleText;
+    for (char c : module)
+    {
+        if (c != '\r')
+        {
+            moduleText += static_cast<char16_t>(c);
+        }
+    }
+    for (BenchmarkTextVariant variant : BENCHMARK_TEXT_VARIANTS)
+    {
+        std::string content = EncodeBenchmarkText(moduleText, variant);
+        boost::filesystem::path moduleCopy = root / "Text" / ("Benchmark_" + GetBenchmarkTextVariantName(variant) + ".module");
+        if (!WriteBenchmarkFile(moduleCopy, content))
+        {
+            return false;
+        }
+        fixture.moduleCopies.push_back(moduleCopy.wstring());
+        fixture.moduleCopyBytes += content.size();
+    }
+
+    // the additional files match their baselines, so the check hashes every pair without restoring any file
+    std::string additionalFiles;
+    std::string content(static_cast<size_t>(options.additionalFileSize), '\0');
+    for (unsigned int i = 0; i < options.additionalFiles; ++i)
+    {
+        std::string baseName = "BenchmarkFile" + std::to_string(i + 1);
+        FillDeterministicData(&content[0], content.size(), 0x1000 + i);
+        if (!WriteBenchmarkFile(root / (baseName + ".dat"), content) || !WriteBenchmarkFile(root / "Bin" / ("Benchmark_" + baseName + ".bin"), content))
+        {
+            return false;
+        }
+        additionalFiles += (additionalFiles.empty() ? "" : ", ") + baseName + ".dat";
+        fixture.additionalBytes += content.size() * 2;
+    }
+
+    std::string config =
+        "IsRetribution=true\r\nIsSteam=true\r\nGameVersion=\r\nBinFolder=Bin\r\nIsDXVK=false\r\nLAAPatch=false\r\nUIWarnings=false\r\nWIN7CompatibilityMode=true\r\n"
+        "LaunchParams=\r\nInjector=false\r\nInjectorFileName=\r\nInjectedFiles=\r\nInjectedConfigurations=\r\nAdditionalFiles=" + additionalFiles + "\r\n"
+        "FirstTimeLaunchCheck=false\r\nFirstTimeLaunchMessage=\r\nVerboseDebug=false\r\nWarnings=false\r\nIgnoredWarnings=\r\nIsUnsafe=false\r\nConsole=true\r\n"
+        "ArchiveVerification=header\r\nShutdownTimeout=30\r\n";
+    if (!WriteBenchmarkFile(fixture.configFilePath, config))
+    {
+        return false;
+    }
+    fixture.configBytes = config.size();
+    return true;
+}
+
+// structure to hold the generated text files in memory, UTF-16 text as code units and UTF-8 text as raw bytes without its BOM, as the line break check scans them
+struct BenchmarkTexts
+{
+    std::vector<std::u16string> utf16;
+    std::vector<std::string> utf8;
+    unsigned long long bytes = 0; // of the files as stored
+};
+
+// function to count the line breaks of a text with the given search, one call per line break as the converters make
+template <typename CharType>
+size_t CountBenchmarkLineBreaks(const std::basic_string<CharType>& text, const CharType* (*findLineBreak)(const CharType*, const CharType*))
+{
+    size_t lineBreaks = 0;
+    const CharType* end = text.data() + text.size();
+    for (const CharType* current = findLineBreak(text.data(), end); current != end; current = findLineBreak(current + 1, end))
+    {
+        ++lineBreaks;
+    }
+    return lineBreaks;
+}
+
+// function to count the line breaks of every loaded text, with the scalar search or the block search
+size_t CountBenchmarkLineBreaks(const BenchmarkTexts& texts, bool scalar)
+{
+    size_t lineBreaks = 0;
+    for (const auto& text : texts.utf8)
+    {
+        lineBreaks += CountBenchmarkLineBreaks(text, scalar ? &FindLineBreakScalar<char> : &FindLineBreak<char>);
+    }
+    for (const auto& text : texts.utf16)
+    {
+        lineBreaks += CountBenchmarkLineBreaks(text, scalar ? &FindLineBreakScalar<char16_t> : &FindLineBreak<char16_t>);
+    }
+    return lineBreaks;
+}
+
+// function to convert line breaks to CRLF one character at a time, as CheckAndConvertToWindowsCRLF did before ConvertToCRLF, kept to compare against it
+template <typename CharType>
+std::basic_string<CharType> ConvertToCRLFAppending(const std::basic_string<CharType>& content)
+{
+    std::basic_string<CharType> convertedContent;
+    for (size_t i = 0; i < content.size(); ++i)
+    {
+        if (content[i] == CharType('\r'))
+        {
+            // an existing CRLF is kept, a lone CR is completed
+            convertedContent += CharType('\r');
+            convertedContent += CharType('\n');
+            if (i + 1 < content.size() && content[i + 1] == CharType('\n'))
+            {
+                ++i;
+            }
+        }
+        else if (content[i] == CharType('\n'))
+        {
+            if (i == 0 || content[i - 1] != CharType('\r'))
+            {
+                convertedContent += CharType('\r');
+                convertedContent += CharType('\n');
+            }
+        }
+        else
+        {
+            convertedContent += content[i];
+        }
+    }
+    return convertedContent;
+}
+
+// function to convert every loaded text to CRLF line breaks, with the appending loop or with ConvertToCRLF, returning the converted length so both can be compared
+size_t ConvertBenchmarkTexts(const BenchmarkTexts& texts, bool appending)
+{
+    size_t convertedLength = 0;
+    for (const auto& text : texts.utf8)
+    {
+        convertedLength += appending ? ConvertToCRLFAppending(text).size() : ConvertToCRLF(text.data(), text.data() + text.size(), CountBareLineBreaks(text.data(), text.data() + text.size())).size();
+    }
+    for (const auto& text : texts.utf16)
+    {
+        convertedLength += appending ? ConvertToCRLFAppending(text).size() : ConvertToCRLF(text.data(), text.data() + text.size(), CountBareLineBreaks(text.data(), text.data() + text.size())).size();
+    }
+    return convertedLength;
+}
+
+// structure to hold the counters sampled before and after a measured pipeline
+struct BenchmarkSample
+{
+    std::chrono::steady_clock::time_point time;
+    unsigned long long allocations = 0;
+    unsigned long long allocatedBytes = 0;
+    unsigned long long peakMemory = 0; // peak working set of the process, or its peak resident set on Linux
+};
+
+// structure to hold the outcome of a measured pipeline
+struct BenchmarkResult
+{
+    std::string name;
+    bool succeeded = false;
+    double seconds = 0.0;
+    unsigned long long bytes = 0; // data the pipeline had to get through, 0 where only the number of files is meaningful
+    unsigned long long files = 0;
+    unsigned long long allocations = 0;
+    unsigned long long allocatedBytes = 0;
+    unsigned long long peakMemory = 0;
+};
+
+// function to sample the time, the allocation counters and the peak memory use of the process
+BenchmarkSample TakeBenchmarkSample()
+{
+    BenchmarkSample sample;
+    sample.allocations = benchmarkAllocations.load(std::memory_order_relaxed);
+    sample.allocatedBytes = benchmarkAllocatedBytes.load(std::memory_order_relaxed);
+#if BOOST_OS_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        sample.peakMemory = counters.PeakWorkingSetSize;
+    }
+#else
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            sample.peakMemory = std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+            break;
+        }
+    }
+#endif
+    sample.time = std::chrono::steady_clock::now();
+    return sample;
+}
+
+// function to measure one run of a pipeline, which returns whether it succeeded
+BenchmarkResult MeasureBenchmark(const std::string& name, unsigned long long bytes, unsigned long long files, const std::function<bool()>& pipeline)
+{
+    BenchmarkResult result;
+    result.name = name;
+    result.bytes = bytes;
+    result.files = files;
+
+    BenchmarkSample before = TakeBenchmarkSample();
+    result.succeeded = pipeline();
+    BenchmarkSample after = TakeBenchmarkSample();
+
+    result.seconds = std::chrono::duration<double>(after.time - before.time).count();
+    result.allocations = after.allocations - before.allocations;
+    result.allocatedBytes = after.allocatedBytes - before.allocatedBytes;
+    result.peakMemory = after.peakMemory;
+    return result;
+}
+
+// function to print the header of the results table
+void PrintBenchmarkHeader()
+{
+    std::cout << std::left << std::setw(48) << "Pipeline" << std::right << std::setw(11) << "Time ms" << std::setw(11) << "MiB/s" << std::setw(11) << "Files/s"
+        << std::setw(12) << "Allocations" << std::setw(12) << "Alloc MiB" << std::setw(11) << "Peak MiB" << std::endl;
+}
+
+// function to print a measured pipeline as a row of the results table
+void PrintBenchmarkResult(const BenchmarkResult& result)
+{
+    const double mebibyte = 1024.0 * 1024.0;
+    double seconds = (std::max)(result.seconds, 1e-9);
+
+    std::cout << std::left << std::setw(48) << result.name << std::right << std::fixed << std::setprecision(1) << std::setw(11) << result.seconds * 1000.0;
+    if (result.bytes > 0)
+    {
+        std::cout << std::setw(11) << result.bytes / mebibyte / seconds;
+    }
+    else
+    {
+        std::cout << std::setw(11) << "-";
+    }
+    std::cout << std::setw(11) << result.files / seconds << std::setw(12) << result.allocations << std::setw(12) << result.allocatedBytes / mebibyte
+        << std::setw(11) << result.peakMemory / mebibyte << (result.succeeded ? "" : "  FAILED") << std::endl;
+}
\ No newline at end of file
@@ -5,6 +5,13 @@
 #define WIN32_LEAN_AND_MEAN
 #define BOOST_DISABLE_CURRENT_LOCATION
 #define TIMEOUT_PROCESS 60000 // absolute timeout for the entire process
+#define MAX_WORKER_THREADS 8 // upper bound for worker threads used by parallel file operations
+#define MAX_REPORTED_ERRORS 20 // upper bound for errors listed in a single aggregated error message
+#define WINDOW_WAIT_POLL_INTERVAL 100 // interval of the fallback checks while waiting for the game window, in milliseconds
+#define RELAUNCH_POLL_INTERVAL 1000 // interval of the process snapshots searching for a relaunched game, in milliseconds
+#define PROCESS_COMMAND_LINE_INFORMATION 60 // process information class returning the command line directly, available since Windows 8.1
+#define PROCESS_IO_PRIORITY_INFORMATION 33 // process information class setting the default I/O priority of a process
+#define GAME_IO_PRIORITY 3 // high I/O priority, requires the privilege to increase scheduling priority, which only elevated tokens hold
 #define CONSOLE_MESSAGE(msg) \
     if (consoleShown) { \
         std::wcout << msg << std::endl; \
@@ -23,6 +30,7 @@
 #include <codecvt>
 #include <locale>
 #include <unordered_map>
+#include <unordered_set>
 #include <algorithm>
 #include <cctype>
 #include <chrono>
@@ -31,27 +39,45 @@
 #include <cwctype>
 #include <iomanip>
 #include <thread>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <mutex>
 
 // windows headers
 #include <windows.h>
 #include <tlhelp32.h>
-#include <wincrypt.h>
 #include <shlobj.h>
 #include <psapi.h>
+#include <winternl.h>
 #include <gdiplus.h>
 
 // boost headers
 #include <boost/process.hpp>
-#include <boost/interprocess/sync/named_mutex.hpp>
-#include <boost/interprocess/exceptions.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/utility/string_view.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/locale.hpp>
 #include <boost/dll/runtime_symbol_info.hpp>
 #include <boost/predef/os.h>
 
+// posix headers
+#if !BOOST_OS_WINDOWS
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
 // local headers
 #include "vulkan/vulkan.h"
+#include "trace.h"
+#include "hashing.h"
+#include "textscan.h"
+#include "archive.h"
+#include "topology.h"
+#ifdef LAUNCHER_BENCHMARK
+#include "benchmark.h"
+#endif
 
 using namespace Gdiplus;
 
@@ -134,6 +160,7 @@ void BitmapThread(HINSTANCE hInstance, const std::wstring& bitmapFileName)
             TranslateMessage(&msg);
             DispatchMessage(&msg);
         }
+        DestroyWindow(hwnd);
     }
 }
 
@@ -296,28 +323,25 @@ void GifThread(HINSTANCE hInstance, const std::wstring& bitmapFileName)
             TranslateMessage(&msg);
             DispatchMessage(&msg);
         }
+        DestroyWindow(hwnd);
     }
 }
 
-// function to get the command line of a process
-std::string GetCommandLineOfProcess(DWORD processID) 
+// function to close a splash screen by ending the message loop of its thread, and wait for the thread to finish
+void StopSplashThread(std::thread& splashThread)
 {
-    std::string commandLine;
-    boost::process::ipstream pipe_stream;
-    boost::process::child c("wmic process where processid=" + std::to_string(processID) + " get CommandLine", boost::process::std_out > pipe_stream);
-
-    std::string line;
-    while (pipe_stream && std::getline(pipe_stream, line) && !line.empty()) 
+    if (!splashThread.joinable())
     {
-        if (line.find("CommandLine") == std::string::npos) // skip the header
-        {
-            commandLine += line;
-        }
+        return;
     }
 
-    c.wait();
-
-    return commandLine;
+    // the message queue of the thread may not exist yet, so the quit message is posted until it is accepted or the thread has finished
+    HANDLE threadHandle = splashThread.native_handle();
+    DWORD threadId = GetThreadId(threadHandle);
+    while (!PostThreadMessage(threadId, WM_QUIT, 0, 0) && WaitForSingleObject(threadHandle, 10) == WAIT_TIMEOUT)
+    {
+    }
+    splashThread.join();
 }
 
 // function to find a process ID
@@ -405,71 +429,6 @@ std::string NormalizeCommandLine(const std::string& commandLine)
     return normalized;
 }
 
-// function to calculate the MD5 checksum of a file
-bool CalculateMD5(const wchar_t* filepath, std::string& md5String)
-{
-    HCRYPTPROV hProv = 0;
-    HCRYPTHASH hHash = 0;
-    HANDLE hFile = CreateFile(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
-    if (hFile == INVALID_HANDLE_VALUE)
-    {
-        return false;
-    }
-
-    if (!CryptAcquireContext(&hProv, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT))
-    {
-        CloseHandle(hFile);
-        return false;
-    }
-
-    if (!CryptCreateHash(hProv, CALG_MD5, 0, 0, &hHash))
-    {
-        CloseHandle(hFile);
-        CryptReleaseContext(hProv, 0);
-        return false;
-    }
-
-    BYTE buffer[4096] = { 0 };
-    DWORD bytesRead = 0;
-    while (ReadFile(hFile, buffer, sizeof(buffer), &bytesRead, NULL) && bytesRead != 0)
-    {
-        if (!CryptHashData(hHash, buffer, bytesRead, 0))
-        {
-            CryptDestroyHash(hHash);
-            CryptReleaseContext(hProv, 0);
-            CloseHandle(hFile);
-            return false;
-        }
-    }
-
-    BYTE rgbHash[16];
-    DWORD cbHash = 16;
-    if (CryptGetHashParam(hHash, HP_HASHVAL, rgbHash, &cbHash, 0))
-    {
-        char hexStr[33] = { 0 };
-        for (DWORD i = 0; i < cbHash; i++)
-        {
-            sprintf(&hexStr[i * 2], "%02x", rgbHash[i]);
-        }
-        hexStr[32] = 0;
-        md5String = hexStr;
-    }
-
-    CryptDestroyHash(hHash);
-    CryptReleaseContext(hProv, 0);
-    CloseHandle(hFile);
-
-    return true;
-}
-
-// function to check CPU core count
-int GetProcessorCoreCount() 
-{
-    SYSTEM_INFO sysinfo;
-    GetSystemInfo(&sysinfo);
-    return sysinfo.dwNumberOfProcessors;
-}
-
 // function to check if a process is running
 bool IsProcessRunning(const wchar_t* processName)
 {
@@ -499,61 +458,78 @@ bool IsProcessRunning(const wchar_t* processName)
     return false;
 }
 
-// function to monitor the process and set priority, and check if the process terminates
-void MonitorAndSetPriority()
+// structure to describe how the game is scheduled, applied while it is still suspended so its first instructions already run under it
+struct GameLaunchPolicy
 {
-    HANDLE processHandle = NULL;
-    while (true)
+    DWORD priorityClass = HIGH_PRIORITY_CLASS;
+    ULONG ioPriority = GAME_IO_PRIORITY;
+    bool disablePowerThrottling = true; // keeps the system from running the game on efficiency cores or at reduced clock speeds while it loads
+    DWORD_PTR affinityMask = 0; // 0 keeps the affinity the game inherits from the launcher
+};
+
+// signature of NtSetInformationProcess, resolved from ntdll at runtime as its import library is not linked
+typedef LONG(NTAPI* NtSetInformationProcessFunction)(HANDLE, ULONG, PVOID, ULONG);
+
+// signature of SetProcessInformation, resolved at runtime as it is missing before Windows 8
+typedef BOOL(WINAPI* SetProcessInformationFunction)(HANDLE, PROCESS_INFORMATION_CLASS, LPVOID, DWORD);
+
+// function to enable a privilege held by the token of the launcher, privileges of an elevated token are held but disabled until enabled
+bool EnableProcessPrivilege(const wchar_t* privilegeName)
+{
+    HANDLE tokenHandle = NULL;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &tokenHandle))
     {
-        HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-        if (hSnapshot == INVALID_HANDLE_VALUE)
-        {
-            Sleep(100); // retry if snapshot fails
-            continue;
-        }
+        return false;
+    }
 
-        PROCESSENTRY32 pe32 = { 0 };
-        pe32.dwSize = sizeof(PROCESSENTRY32);
+    TOKEN_PRIVILEGES privileges = {};
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    bool enabled = false;
+    if (LookupPrivilegeValueW(NULL, privilegeName, &privileges.Privileges[0].Luid))
+    {
+        // the call also succeeds for a privilege the token does not hold, which only the last error tells apart
+        enabled = AdjustTokenPrivileges(tokenHandle, FALSE, &privileges, sizeof(privileges), NULL, NULL) && GetLastError() == ERROR_SUCCESS;
+    }
 
-        bool processFound = false;
+    CloseHandle(tokenHandle);
+    return enabled;
+}
 
-        if (Process32First(hSnapshot, &pe32))
-        {
-            do
-            {
-                if (wcscmp(pe32.szExeFile, APP_NAME) == 0)
-                {
-                    processFound = true;
-                    processHandle = OpenProcess(PROCESS_SET_INFORMATION, FALSE, pe32.th32ProcessID);
-                    if (processHandle)
-                    {
-                        if (SetPriorityClass(processHandle, HIGH_PRIORITY_CLASS))
-                        {
-                            // confirm the priority has been set correctly
-                            if (GetPriorityClass(processHandle) == HIGH_PRIORITY_CLASS)
-                            {
-                                CloseHandle(processHandle);
-                                CloseHandle(hSnapshot);
-                                return;
-                            }
-                        }
-                        CloseHandle(processHandle);
-                        processHandle = NULL;
-                    }
-                }
-            } 
-            while (Process32Next(hSnapshot, &pe32));
-        }
+// function to apply the launch policy to the game, the priority class is required while the other settings are applied where the system supports them
+// the I/O priority is reported separately, as the launcher may lack the privilege it requires
+bool ApplyGameLaunchPolicy(HANDLE processHandle, const GameLaunchPolicy& policy, bool& ioPriorityApplied)
+{
+    ioPriorityApplied = false;
+    if (!SetPriorityClass(processHandle, policy.priorityClass))
+    {
+        return false;
+    }
 
-        CloseHandle(hSnapshot);
+    NtSetInformationProcessFunction setInformation = reinterpret_cast<NtSetInformationProcessFunction>(GetProcAddress(GetModuleHandle(L"ntdll.dll"), "NtSetInformationProcess"));
+    if (setInformation != NULL && EnableProcessPrivilege(SE_INC_BASE_PRIORITY_NAME))
+    {
+        // a negative status is an error, the game then keeps the normal I/O priority
+        ULONG ioPriority = policy.ioPriority;
+        ioPriorityApplied = setInformation(processHandle, PROCESS_IO_PRIORITY_INFORMATION, &ioPriority, sizeof(ioPriority)) >= 0;
+    }
 
-        if (!processFound)
-        {
-            exit(1);
-        }
+    SetProcessInformationFunction setProcessInformation = reinterpret_cast<SetProcessInformationFunction>(GetProcAddress(GetModuleHandle(L"kernel32.dll"), "SetProcessInformation"));
+    if (policy.disablePowerThrottling && setProcessInformation != NULL)
+    {
+        PROCESS_POWER_THROTTLING_STATE throttlingState = {};
+        throttlingState.Version = PROCESS_POWER_THROTTLING_CURRENT_VERSION;
+        throttlingState.ControlMask = PROCESS_POWER_THROTTLING_EXECUTION_SPEED;
+        throttlingState.StateMask = 0;
+        setProcessInformation(processHandle, ProcessPowerThrottling, &throttlingState, sizeof(throttlingState));
+    }
 
-        Sleep(1000); // check every set amount of seconds
+    if (policy.affinityMask != 0)
+    {
+        SetProcessAffinityMask(processHandle, policy.affinityMask);
     }
+
+    return GetPriorityClass(processHandle) == policy.priorityClass;
 }
 
 // function to get the string file info from a file's version info
@@ -630,6 +606,41 @@ std::map<std::wstring, std::wstring> GetFileVersionStrings(const std::wstring& f
     return versionInfoStrings;
 }
 
+// structure to hold the errors reported while they are captured instead of shown, so a run without a user, such as the benchmark, can report them itself
+struct ErrorReport
+{
+    bool capturing = false;
+    std::vector<std::wstring> messages;
+    std::mutex mutex;
+};
+
+// global error report
+ErrorReport errorReport;
+
+// function to report an error, shown in a message box unless errors are being captured
+void ReportError(const std::wstring& message)
+{
+    {
+        std::lock_guard<std::mutex> lock(errorReport.mutex);
+        if (errorReport.capturing)
+        {
+            errorReport.messages.push_back(message);
+            return;
+        }
+    }
+    MessageBox(NULL, message.c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+}
+
+// function to start or stop capturing errors, returning the errors captured since capturing started
+std::vector<std::wstring> CaptureErrors(bool capturing)
+{
+    std::lock_guard<std::mutex> lock(errorReport.mutex);
+    std::vector<std::wstring> messages;
+    messages.swap(errorReport.messages);
+    errorReport.capturing = capturing;
+    return messages;
+}
+
 // console control handler function
 BOOL WINAPI ConsoleHandler(DWORD dwCtrlType)
 {
@@ -865,6 +876,183 @@ HWND GetMainWindowHandle(DWORD processId)
     return info.hwnd;
 }
 
+// structure to hold the state of a wait for a process window, shared with the window event hook callback
+struct ProcessWindowWait
+{
+    DWORD processId = 0;
+    HWND windowHandle = NULL;
+};
+
+// global window wait state, window event hooks cannot carry a context pointer
+ProcessWindowWait processWindowWait;
+
+// function to receive window show and title change events of the awaited process, recording its first titled top-level window
+void CALLBACK ProcessWindowEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject, LONG idChild, DWORD eventThread, DWORD eventTime)
+{
+    if (idObject != OBJID_WINDOW || idChild != CHILDID_SELF || hwnd == NULL || processWindowWait.windowHandle != NULL)
+    {
+        return;
+    }
+    if (GetAncestor(hwnd, GA_ROOT) != hwnd)
+    {
+        return;
+    }
+
+    DWORD windowProcessId = 0;
+    GetWindowThreadProcessId(hwnd, &windowProcessId);
+    if (windowProcessId == processWindowWait.processId && GetWindowTextLength(hwnd) > 0)
+    {
+        processWindowWait.windowHandle = hwnd;
+    }
+}
+
+// function to wait until a process has a titled top-level window, false if the process exits or the deadline passes first
+// window events wake the wait as soon as the window is shown or titled, a check every WINDOW_WAIT_POLL_INTERVAL catches anything the events miss
+bool WaitForProcessWindow(HANDLE processHandle, DWORD processId, DWORD64 deadline, HWND& windowHandle)
+{
+    processWindowWait.processId = processId;
+    processWindowWait.windowHandle = NULL;
+
+    // the hooks are delivered to this thread while it waits for messages, and only for the awaited process
+    HWINEVENTHOOK showHook = SetWinEventHook(EVENT_OBJECT_SHOW, EVENT_OBJECT_SHOW, NULL, ProcessWindowEventProc, processId, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+    HWINEVENTHOOK nameHook = SetWinEventHook(EVENT_OBJECT_NAMECHANGE, EVENT_OBJECT_NAMECHANGE, NULL, ProcessWindowEventProc, processId, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+
+    // the window may already exist before the hooks were installed
+    windowHandle = GetMainWindowHandle(processId);
+    bool processExited = false;
+
+    while (windowHandle == NULL && !processExited)
+    {
+        DWORD64 now = GetTickCount64();
+        if (now >= deadline)
+        {
+            break;
+        }
+        DWORD waitTime = static_cast<DWORD>((std::min)(deadline - now, static_cast<DWORD64>(WINDOW_WAIT_POLL_INTERVAL)));
+
+        DWORD waitResult = MsgWaitForMultipleObjects(1, &processHandle, FALSE, waitTime, QS_ALLINPUT);
+        if (waitResult == WAIT_OBJECT_0)
+        {
+            processExited = true;
+        }
+        else if (waitResult == WAIT_OBJECT_0 + 1)
+        {
+            MSG msg;
+            while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+            {
+                TranslateMessage(&msg);
+                DispatchMessage(&msg);
+            }
+            windowHandle = processWindowWait.windowHandle;
+        }
+        else if (waitResult == WAIT_TIMEOUT)
+        {
+            // windows are only enumerated once the process has started processing input, or when it has no input queue to wait for
+            DWORD idleResult = WaitForInputIdle(processHandle, 0);
+            if (idleResult == 0 || idleResult == WAIT_FAILED)
+            {
+                windowHandle = GetMainWindowHandle(processId);
+            }
+        }
+        else
+        {
+            Sleep(WINDOW_WAIT_POLL_INTERVAL);
+        }
+    }
+
+    if (showHook != NULL)
+    {
+        UnhookWinEvent(showHook);
+    }
+    if (nameHook != NULL)
+    {
+        UnhookWinEvent(nameHook);
+    }
+    return windowHandle != NULL;
+}
+
+// function to check if a window is shown and processes its messages within the poll interval
+bool IsWindowResponsive(HWND hwnd)
+{
+    DWORD_PTR result = 0;
+    return IsWindowVisible(hwnd) && !IsHungAppWindow(hwnd) && SendMessageTimeout(hwnd, WM_NULL, 0, 0, SMTO_ABORTIFHUNG | SMTO_BLOCK, WINDOW_WAIT_POLL_INTERVAL, &result) != 0;
+}
+
+// function to wait until the launcher can close: the main window of the game is shown and responsive, and the game runs at the requested priority class, 0 requiring none
+// returns false if the game exits or the deadline passes first
+bool WaitForGameReady(DWORD processId, HWND windowHandle, DWORD priorityClass, DWORD64 deadline)
+{
+    TRACE_SCOPE("WaitForGameReady");
+    HANDLE processHandle = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
+    if (processHandle == NULL)
+    {
+        return false;
+    }
+
+    bool ready = false;
+    while (true)
+    {
+        // the game may replace its first window while it initializes the renderer
+        if (!IsWindow(windowHandle))
+        {
+            windowHandle = GetMainWindowHandle(processId);
+        }
+        if (windowHandle != NULL && IsWindowResponsive(windowHandle) && (priorityClass == 0 || GetPriorityClass(processHandle) == priorityClass))
+        {
+            ready = true;
+            break;
+        }
+
+        DWORD64 now = GetTickCount64();
+        if (now >= deadline)
+        {
+            break;
+        }
+        DWORD waitTime = static_cast<DWORD>((std::min)(deadline - now, static_cast<DWORD64>(WINDOW_WAIT_POLL_INTERVAL)));
+        if (WaitForSingleObject(processHandle, waitTime) != WAIT_TIMEOUT)
+        {
+            break;
+        }
+    }
+
+    CloseHandle(processHandle);
+    return ready;
+}
+
+// function to wait for the launched game to show its main window, following the game by name if the launched process exits first, as it does when it relaunches itself
+bool WaitForGameWindow(HANDLE processHandle, DWORD processId, const wchar_t* processName, DWORD64 deadline, DWORD& gameProcessId, HWND& windowHandle)
+{
+    TRACE_SCOPE("WaitForGameWindow");
+    gameProcessId = processId;
+    if (WaitForProcessWindow(processHandle, processId, deadline, windowHandle))
+    {
+        return true;
+    }
+
+    // a relaunched game usually exists by the time the launched process exits, so it is searched for at once and then at the slower snapshot interval
+    DWORD64 now;
+    while ((now = GetTickCount64()) < deadline)
+    {
+        DWORD relaunchedProcessId = FindProcessId(processName);
+        HANDLE relaunchedProcess = (relaunchedProcessId != 0 && relaunchedProcessId != processId) ? OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, relaunchedProcessId) : NULL;
+        if (relaunchedProcess == NULL)
+        {
+            Sleep(static_cast<DWORD>((std::min)(deadline - now, static_cast<DWORD64>(RELAUNCH_POLL_INTERVAL))));
+            continue;
+        }
+
+        gameProcessId = relaunchedProcessId;
+        processId = relaunchedProcessId;
+        bool windowFound = WaitForProcessWindow(relaunchedProcess, relaunchedProcessId, deadline, windowHandle);
+        CloseHandle(relaunchedProcess);
+        if (windowFound)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 // function to force focus on the window
 void ForceFocusOnWindow(HWND hwnd)
 {
@@ -1046,151 +1234,6 @@ bool RemoveWin7RtmCompatibilityMode(const std::wstring& exePath)
     return true;
 }
 
-bool CheckAndConvertToWindowsCRLF(const std::wstring& fileName)
-{
-    // read the BOM to determine the encoding
-    std::ifstream file(fileName, std::ios::binary);
-    if (!file.is_open())
-    {
-        return false;
-    }
-
-    // read entire file content into a string
-    std::string raw_content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    file.close();
-
-    // check and determine the encoding
-    std::wstring content;
-    if (raw_content.size() >= 2 && raw_content[0] == char(0xFF) && raw_content[1] == char(0xFE))
-    {
-        // UTF-16 LE
-        content = std::wstring(reinterpret_cast<const wchar_t*>(raw_content.data() + 2), (raw_content.size() - 2) / 2);
-    }
-    else if (raw_content.size() >= 2 && raw_content[0] == char(0xFE) && raw_content[1] == char(0xFF))
-    {
-        // UTF-16 BE
-        std::wstring utf16be_content(reinterpret_cast<const wchar_t*>(raw_content.data() + 2), (raw_content.size() - 2) / 2);
-        // swap bytes to convert from BE to LE
-        for (size_t i = 0; i < utf16be_content.size(); ++i)
-        {
-            wchar_t ch = utf16be_content[i];
-            utf16be_content[i] = (ch >> 8) | (ch << 8);
-        }
-        content = utf16be_content;
-    }
-    else if (raw_content.size() >= 3 && raw_content[0] == char(0xEF) && raw_content[1] == char(0xBB) && raw_content[2] == char(0xBF))
-    {
-        // UTF-8 with BOM
-        std::string utf8_content = raw_content.substr(3);
-        content = boost::locale::conv::utf_to_utf<wchar_t>(utf8_content);
-    }
-    else
-    {
-        // assume UTF-8 without BOM
-        content = boost::locale::conv::utf_to_utf<wchar_t>(raw_content);
-    }
-
-    // check if conversion to CRLF is needed
-    bool needsConversion = false;
-    for (size_t i = 0; i < content.size(); ++i)
-    {
-        if ((content[i] == L'\n' && (i == 0 || content[i - 1] != L'\r')) || content[i] == L'\r')
-        {
-            if (content[i] == L'\r' && (i + 1 >= content.size() || content[i + 1] != L'\n'))
-            {
-                // found CR without LF, needs conversion
-                needsConversion = true;
-                break;
-            }
-            if (content[i] == L'\n' && (i == 0 || content[i - 1] != L'\r'))
-            {
-                // found LF without preceding CR, needs conversion
-                needsConversion = true;
-                break;
-            }
-        }
-    }
-
-    if (!needsConversion)
-    {
-        return true; // file is already in CRLF format
-    }
-
-    // convert content to CRLF format
-    std::wstring convertedContent;
-    for (size_t i = 0; i < content.size(); ++i)
-    {
-        if (content[i] == L'\r')
-        {
-            if (i + 1 < content.size() && content[i + 1] == L'\n')
-            {
-                // handle already existing CRLF
-                convertedContent += L"\r\n";
-                ++i; // Skip the '\n'
-            }
-            else
-            {
-                // handle Macintosh CR
-                convertedContent += L"\r\n";
-            }
-        }
-        else if (content[i] == L'\n')
-        {
-            if (i == 0 || content[i - 1] != L'\r')
-            {
-                // handle LF not preceded by CR (Unix LF)
-                convertedContent += L"\r\n";
-            }
-        }
-        else
-        {
-            convertedContent += content[i];
-        }
-    }
-
-    // write the converted content back to the file
-    std::wofstream outFile(fileName, std::ios::binary | std::ios::trunc);
-    if (!outFile.is_open())
-    {
-        return false;
-    }
-
-    if (raw_content.size() >= 2 && raw_content[0] == char(0xFF) && raw_content[1] == char(0xFE))
-    {
-        // UTF-16 LE
-        outFile.imbue(std::locale(outFile.getloc(), new std::codecvt_utf16<wchar_t, 0x10FFFF, std::little_endian>));
-        outFile.write(L"\uFEFF", 1); // write BOM
-    }
-    else if (raw_content.size() >= 2 && raw_content[0] == char(0xFE) && raw_content[1] == char(0xFF))
-    {
-        // UTF-16 BE
-        outFile.imbue(std::locale(outFile.getloc(), new std::codecvt_utf16<wchar_t, 0x10FFFF, std::consume_header>));
-        outFile.write(L"\uFEFF", 1); // write BOM
-        for (size_t i = 0; i < convertedContent.size(); ++i)
-        {
-            wchar_t ch = convertedContent[i];
-            wchar_t be_ch = (ch >> 8) | (ch << 8);
-            outFile.write(&be_ch, 1);
-        }
-        outFile.close();
-        return true;
-    }
-    else
-    {
-        // UTF-8
-        outFile.imbue(std::locale(outFile.getloc(), new std::codecvt_utf8<wchar_t>));
-        if (raw_content.size() >= 3 && raw_content[0] == char(0xEF) && raw_content[1] == char(0xBB) && raw_content[2] == char(0xBF))
-        {
-            outFile << L'\uFEFF'; // write BOM if it was present in the original file
-        }
-    }
-
-    outFile.write(convertedContent.c_str(), convertedContent.size());
-    outFile.close();
-
-    return true;
-}
-
 typedef VkResult(VKAPI_PTR* PFN_vkCreateInstance)(const VkInstanceCreateInfo*, const VkAllocationCallbacks*, VkInstance*);
 typedef void (VKAPI_PTR* PFN_vkDestroyInstance)(VkInstance, const VkAllocationCallbacks*);
 typedef VkResult(VKAPI_PTR* PFN_vkEnumeratePhysicalDevices)(VkInstance, uint32_t*, VkPhysicalDevice*);
@@ -1232,6 +1275,7 @@ PFN_vkGetPhysicalDeviceProperties GetVkGetPhysicalDevicePropertiesFunction(HMODU
 // function to check for GPU vulkan support
 bool HasVulkanSupport()
 {
+    TRACE_SCOPE("HasVulkanSupport");
     // load Vulkan library
     HMODULE vulkanLib = LoadVulkanLibrary();
     if (!vulkanLib)
@@ -1309,46 +1353,50 @@ std::string get_current_process_name()
     return executableName;
 }
 
-// function to check if a process with the given name is already running
-bool is_process_running(const std::string& process_name) 
+// structure to keep a second launcher of the same name from running, the lock is held until the structure goes out of scope
+// the system releases the lock when the process ends by any other path, so an exit or a crash never leaves it behind
+struct SingleInstanceGuard
 {
-    // determine which command to use based on the platform
-    std::string command = bp::search_path("tasklist").string();
-    std::vector<std::string> args;
-
-    if (!command.empty()) 
-    {
-        // windows platform
-        args = { "/FI", "IMAGENAME eq " + process_name };
-    }
-    else 
-    {
-        // unix-like platform
-        command = bp::search_path("pgrep").string();
-        args = { process_name };
-    }
-
-    bp::ipstream pipe_stream;
-    bp::child c(command, bp::args(args), bp::std_out > pipe_stream);
-
-    std::string line;
-    int count = 0;
-    while (pipe_stream && std::getline(pipe_stream, line) && !line.empty()) 
-    {
-        if (line.find(process_name) != std::string::npos) 
-        {
-            ++count;
-            if (count > 1) 
-            {
-                c.terminate();
-                return true;
-            }
-        }
+    bool acquired = false;
+#if BOOST_OS_WINDOWS
+    HANDLE mutexHandle = NULL;
+#else
+    int lockFile = -1;
+#endif
+
+    explicit SingleInstanceGuard(const std::string& instanceName)
+    {
+#if BOOST_OS_WINDOWS
+        // a local mutex is shared by every process of the current session, only whether it already existed matters
+        std::wstring mutexName = L"Local\\DOW2Launcher." + boost::locale::conv::utf_to_utf<wchar_t>(boost::algorithm::to_lower_copy(instanceName));
+        mutexHandle = CreateMutexW(NULL, FALSE, mutexName.c_str());
+        acquired = mutexHandle != NULL && GetLastError() != ERROR_ALREADY_EXISTS;
+#else
+        // a lock taken with flock belongs to the open file, so a second open of the same file cannot take it, even from the same process
+        std::string lockFilePath = (boost::filesystem::temp_directory_path() / ("DOW2Launcher." + instanceName + ".lock")).string();
+        lockFile = open(lockFilePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        acquired = lockFile != -1 && flock(lockFile, LOCK_EX | LOCK_NB) == 0;
+#endif
+    }
+
+    ~SingleInstanceGuard()
+    {
+#if BOOST_OS_WINDOWS
+        if (mutexHandle != NULL)
+        {
+            CloseHandle(mutexHandle);
+        }
+#else
+        if (lockFile != -1)
+        {
+            close(lockFile);
+        }
+#endif
     }
 
-    c.wait();
-    return false;
-}
+    SingleInstanceGuard(const SingleInstanceGuard&) = delete;
+    SingleInstanceGuard& operator=(const SingleInstanceGuard&) = delete;
+};
 
 // simple function to check if a file exists
 bool FileExists(const std::string& path) 
@@ -1376,16 +1424,42 @@ std::string TrimString(const std::string& str)
     return str.substr(first, last - first + 1);
 }
 
-// function to validate launch parameter field formatting
-bool ValidateLaunchParams(const std::wstring& launchParams)
+// helper function to trim spaces from a wide string view without copying it
+boost::wstring_view TrimWStringView(boost::wstring_view str)
 {
-    std::wistringstream iss(launchParams);
-    std::wstring token;
-    std::wregex paramRegex(L"^-\\w+|^-\\w+\\s+\\w+$");
+    size_t first = str.find_first_not_of(L' ');
+    if (first == boost::wstring_view::npos)
+        return boost::wstring_view();
+    size_t last = str.find_last_not_of(L' ');
+    return str.substr(first, last - first + 1);
+}
 
-    while (iss >> token)
+// function to validate launch parameter field formatting, every whitespace separated token must be a [-] sign followed by word characters
+bool ValidateLaunchParams(boost::wstring_view launchParams)
+{
+    size_t pos = 0;
+    while (pos < launchParams.size())
     {
-        if (!std::regex_match(token, paramRegex))
+        if (std::iswspace(launchParams[pos]))
+        {
+            ++pos;
+            continue;
+        }
+
+        if (launchParams[pos] != L'-')
+        {
+            return false;
+        }
+        size_t tokenStart = ++pos;
+        while (pos < launchParams.size() && !std::iswspace(launchParams[pos]))
+        {
+            if (!std::iswalnum(launchParams[pos]) && launchParams[pos] != L'_')
+            {
+                return false;
+            }
+            ++pos;
+        }
+        if (pos == tokenStart)
         {
             return false;
         }
@@ -1395,23 +1469,34 @@ bool ValidateLaunchParams(const std::wstring& launchParams)
 }
 
 // function to validate file name field formatting
-bool ValidateFileName(const std::wstring& fileName)
+bool ValidateFileName(boost::wstring_view fileName)
 {
-    size_t pos = fileName.find(L".");
-    return (pos != std::wstring::npos) && (pos < fileName.length() - 1);
+    size_t pos = fileName.find(L'.');
+    return (pos != boost::wstring_view::npos) && (pos < fileName.length() - 1);
 }
 
 // function to validate boolean fields
-bool ValidateBooleanField(const std::wstring& value)
+bool ValidateBooleanField(boost::wstring_view value)
 {
     return value == L"true" || value == L"false";
 }
 
 // function to validate integer fields
-bool ValidateIntegerField(const std::wstring& value)
+bool ValidateIntegerField(boost::wstring_view value)
 {
-    std::wregex intRegex(L"^-?\\d+$");
-    return std::regex_match(value, intRegex);
+    size_t pos = (!value.empty() && value[0] == L'-') ? 1 : 0;
+    if (pos == value.size())
+    {
+        return false;
+    }
+    for (; pos < value.size(); ++pos)
+    {
+        if (value[pos] < L'0' || value[pos] > L'9')
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
 // function to check if we're running on Windows
@@ -1437,25 +1522,1144 @@ std::wstring StringToWString(const std::string& str) {
     return boost::locale::conv::utf_to_utf<wchar_t>(str);
 }
 
-// function to copy raw data from source to destination
-bool CopyFileRaw(const std::wstring& srcFilePath, const std::wstring& dstFilePath) 
+#if BOOST_OS_WINDOWS
+// signature of NtQueryInformationProcess, resolved from ntdll at runtime as its import library is not linked
+typedef NTSTATUS(NTAPI* NtQueryInformationProcessFunction)(HANDLE, PROCESSINFOCLASS, PVOID, ULONG, PULONG);
+
+// function to read the command line of a process from its process environment block, for systems without the direct information class
+bool ReadCommandLineFromPeb(HANDLE processHandle, NtQueryInformationProcessFunction queryInformation, std::wstring& commandLine)
 {
-    try 
+    PROCESS_BASIC_INFORMATION basicInformation = {};
+    if (queryInformation(processHandle, ProcessBasicInformation, &basicInformation, sizeof(basicInformation), NULL) != 0 || basicInformation.PebBaseAddress == NULL)
     {
-        boost::filesystem::copy_file(boost::locale::conv::utf_to_utf<char>(srcFilePath),
-            boost::locale::conv::utf_to_utf<char>(dstFilePath),
-            boost::filesystem::copy_options::overwrite_existing);
-        return true;
+        return false;
+    }
+
+    PEB peb;
+    RTL_USER_PROCESS_PARAMETERS parameters;
+    if (!ReadProcessMemory(processHandle, basicInformation.PebBaseAddress, &peb, sizeof(peb), NULL) ||
+        !ReadProcessMemory(processHandle, peb.ProcessParameters, &parameters, sizeof(parameters), NULL))
+    {
+        return false;
+    }
+
+    commandLine.assign(parameters.CommandLine.Length / sizeof(wchar_t), L'\0');
+    return commandLine.empty() || ReadProcessMemory(processHandle, parameters.CommandLine.Buffer, &commandLine[0], parameters.CommandLine.Length, NULL) != 0;
+}
+#endif
+
+// function to read the command line of a running process without starting another program
+// on Linux the arguments are joined with spaces, quoting those that contain spaces, to match the form of a Windows command line
+bool ReadProcessCommandLine(unsigned long processId, std::wstring& commandLine)
+{
+    commandLine.clear();
+#if BOOST_OS_WINDOWS
+    NtQueryInformationProcessFunction queryInformation = reinterpret_cast<NtQueryInformationProcessFunction>(GetProcAddress(GetModuleHandle(L"ntdll.dll"), "NtQueryInformationProcess"));
+    if (queryInformation == NULL)
+    {
+        return false;
+    }
+
+    HANDLE processHandle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
+    if (processHandle == NULL)
+    {
+        return false;
+    }
+
+    // the information class fills the buffer with a UNICODE_STRING followed by the characters it points to
+    ULONG bufferSize = 0;
+    queryInformation(processHandle, static_cast<PROCESSINFOCLASS>(PROCESS_COMMAND_LINE_INFORMATION), NULL, 0, &bufferSize);
+    bool found = false;
+    if (bufferSize >= sizeof(UNICODE_STRING))
+    {
+        std::vector<unsigned char> buffer(bufferSize);
+        if (queryInformation(processHandle, static_cast<PROCESSINFOCLASS>(PROCESS_COMMAND_LINE_INFORMATION), buffer.data(), bufferSize, &bufferSize) == 0)
+        {
+            const UNICODE_STRING* text = reinterpret_cast<const UNICODE_STRING*>(buffer.data());
+            commandLine.assign(text->Buffer, text->Length / sizeof(wchar_t));
+            found = true;
+        }
+    }
+    CloseHandle(processHandle);
+
+    if (!found)
+    {
+        processHandle = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, processId);
+        if (processHandle == NULL)
+        {
+            return false;
+        }
+        found = ReadCommandLineFromPeb(processHandle, queryInformation, commandLine);
+        CloseHandle(processHandle);
     }
-    catch (const boost::filesystem::filesystem_error& e) 
+    return found;
+#else
+    std::ifstream cmdlineFile("/proc/" + std::to_string(processId) + "/cmdline", std::ios::binary);
+    if (!cmdlineFile.is_open())
     {
-        std::cerr << e.what() << std::endl;
         return false;
     }
+    std::string arguments((std::istreambuf_iterator<char>(cmdlineFile)), std::istreambuf_iterator<char>());
+
+    // every argument is terminated by a null character
+    std::string joined;
+    size_t start = 0;
+    while (start < arguments.size())
+    {
+        size_t end = arguments.find('\0', start);
+        if (end == std::string::npos)
+        {
+            end = arguments.size();
+        }
+        std::string argument = arguments.substr(start, end - start);
+        if (!joined.empty())
+        {
+            joined += ' ';
+        }
+        joined += (argument.find(' ') != std::string::npos) ? "\"" + argument + "\"" : argument;
+        start = end + 1;
+    }
+    commandLine = StringToWString(joined);
+    return true;
+#endif
+}
+
+// function to get the command line of a process, empty if it cannot be read
+std::string GetCommandLineOfProcess(unsigned long processId)
+{
+    TRACE_SCOPE("GetCommandLineOfProcess");
+    std::wstring commandLine;
+    if (!ReadProcessCommandLine(processId, commandLine))
+    {
+        return std::string();
+    }
+    return WStringToString(commandLine);
 }
 
 // function to verify the 16:9 aspect ratio
 bool CheckAspectRatio(int width, int height) 
 {
     return (width * 9 == height * 16);
+}
+
+// structure to hold the lower case names of the entries found in one directory listing
+struct DirectorySnapshot
+{
+    bool exists = false;
+    std::unordered_set<std::wstring> entries;
+};
+
+// structure to hold the directory listings taken so far, keyed by lower case directory path
+struct DirectoryCache
+{
+    std::unordered_map<std::wstring, DirectorySnapshot> snapshots;
+    std::mutex mutex;
+};
+
+// global directory cache, existence checks are answered from one listing per directory
+DirectoryCache directoryCache;
+
+// function to lower case a path for case-insensitive lookups, treating both separators alike
+std::wstring ToLowerPath(const std::wstring& path)
+{
+    std::wstring lowerPath(path);
+    for (wchar_t& ch : lowerPath)
+    {
+        ch = (ch == L'/') ? L'\\' : static_cast<wchar_t>(towlower(ch));
+    }
+    return lowerPath;
+}
+
+// function to split a path into its directory and entry name, an empty directory stands for the current directory
+void SplitPath(const std::wstring& path, std::wstring& directory, std::wstring& name)
+{
+    std::wstring trimmedPath(path);
+    while (trimmedPath.size() > 1 && (trimmedPath.back() == L'\\' || trimmedPath.back() == L'/'))
+    {
+        trimmedPath.pop_back();
+    }
+
+    size_t separatorPos = trimmedPath.find_last_of(L"\\/");
+    if (separatorPos == std::wstring::npos)
+    {
+        directory.clear();
+        name = trimmedPath;
+    }
+    else
+    {
+        directory = trimmedPath.substr(0, separatorPos == 0 ? 1 : separatorPos);
+        name = trimmedPath.substr(separatorPos + 1);
+    }
+}
+
+// function to list a directory, storing the lower case names of its entries
+void TakeDirectorySnapshot(const std::wstring& directory, DirectorySnapshot& snapshot)
+{
+    std::wstring listedDirectory = directory.empty() ? L"." : directory;
+#if BOOST_OS_WINDOWS
+    if (listedDirectory.size() == 2 && listedDirectory[1] == L':')
+    {
+        listedDirectory += L"\\";
+    }
+
+    WIN32_FIND_DATAW findData;
+    HANDLE hFind = FindFirstFileExW((listedDirectory + (listedDirectory.back() == L'\\' ? L"*" : L"\\*")).c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (hFind == INVALID_HANDLE_VALUE)
+    {
+        snapshot.exists = false;
+        return;
+    }
+
+    snapshot.exists = true;
+    do
+    {
+        snapshot.entries.insert(ToLowerPath(findData.cFileName));
+    }
+    while (FindNextFileW(hFind, &findData) != 0);
+    FindClose(hFind);
+#else
+    boost::system::error_code ec;
+    boost::filesystem::directory_iterator it(boost::filesystem::path(boost::locale::conv::utf_to_utf<char>(listedDirectory)), ec);
+    if (ec)
+    {
+        snapshot.exists = false;
+        return;
+    }
+
+    snapshot.exists = true;
+    for (; it != boost::filesystem::directory_iterator(); it.increment(ec))
+    {
+        if (ec)
+        {
+            break;
+        }
+        snapshot.entries.insert(ToLowerPath(boost::locale::conv::utf_to_utf<wchar_t>(it->path().filename().string())));
+    }
+#endif
+}
+
+// function to check whether a file or directory exists, listing its parent directory the first time it is asked about
+bool PathExists(const std::wstring& path)
+{
+    std::wstring directory;
+    std::wstring name;
+    SplitPath(path, directory, name);
+    if (name.empty() || name == L"." || name == L".." || name.back() == L':')
+    {
+        // roots, drive letters and relative parents are not listed under their own name
+        boost::system::error_code ec;
+        return boost::filesystem::exists(boost::filesystem::path(path), ec);
+    }
+
+    // the listing is taken with the directory as written, later lookups in any letter case share it
+    std::wstring directoryKey = ToLowerPath(directory);
+    std::lock_guard<std::mutex> lock(directoryCache.mutex);
+    auto it = directoryCache.snapshots.find(directoryKey);
+    if (it == directoryCache.snapshots.end())
+    {
+        it = directoryCache.snapshots.emplace(directoryKey, DirectorySnapshot()).first;
+        TakeDirectorySnapshot(directory, it->second);
+    }
+    return it->second.exists && it->second.entries.count(ToLowerPath(name)) > 0;
+}
+
+// function to drop the cached listing of the directory holding a path, after a file in it has been created, replaced or deleted
+void InvalidateDirectoryCache(const std::wstring& path)
+{
+    std::wstring directory;
+    std::wstring name;
+    SplitPath(path, directory, name);
+
+    std::lock_guard<std::mutex> lock(directoryCache.mutex);
+    directoryCache.snapshots.erase(ToLowerPath(directory));
+}
+
+// function to write a header and content to a file, through a temporary file renamed over the target
+bool WriteWholeFile(const std::wstring& filePath, const void* header, size_t headerSize, const void* content, size_t contentSize)
+{
+    std::wstring tempFilePath = filePath + L".tmp";
+    PortableFile file;
+    if (!CreatePortableFile(tempFilePath.c_str(), file))
+    {
+        return false;
+    }
+
+    bool success = WritePortableFile(file, header, headerSize) &&
+        WritePortableFile(file, content, contentSize) &&
+        FlushPortableFile(file);
+    ClosePortableFile(file);
+
+    if (!success || !ReplacePortableFile(tempFilePath.c_str(), filePath.c_str()))
+    {
+        DeletePortableFile(tempFilePath.c_str());
+        return false;
+    }
+    InvalidateDirectoryCache(filePath);
+    return true;
+}
+
+// function to calculate the MD5 checksum of a file
+bool CalculateMD5(const wchar_t* filepath, std::string& md5String)
+{
+    return CalculateFileHash(filepath, HashAlgorithm::MD5, md5String);
+}
+
+// function to build the key of a file in a persistent table, so every spelling of the same path maps to one row
+std::wstring GetFilePathKey(const std::wstring& filePath)
+{
+    try
+    {
+        return boost::filesystem::absolute(boost::filesystem::path(filePath)).lexically_normal().wstring();
+    }
+    catch (const boost::filesystem::filesystem_error&)
+    {
+        return filePath;
+    }
+}
+
+// structure to hold a table persisted between launches as tab-separated rows under a header line, keyed by absolute file path
+template<typename EntryType>
+struct PersistentTable
+{
+    const char* header;
+    std::wstring tableFilePath;
+    std::map<std::wstring, EntryType> entries;
+    std::mutex mutex;
+    bool dirty = false;
+
+    explicit PersistentTable(const char* tableHeader) : header(tableHeader) {}
+};
+
+// function to load a persistent table from disk, a missing or malformed table file simply starts an empty table
+template<typename EntryType>
+void LoadPersistentTable(PersistentTable<EntryType>& table, const std::wstring& tableFilePath)
+{
+    std::lock_guard<std::mutex> lock(table.mutex);
+    table.tableFilePath = tableFilePath;
+    table.entries.clear();
+    table.dirty = false;
+
+    std::ifstream tableFile(tableFilePath, std::ios::binary);
+    if (!tableFile.is_open())
+    {
+        return;
+    }
+
+    std::string line;
+    if (!std::getline(tableFile, line) || line != table.header)
+    {
+        return;
+    }
+
+    // every row ends with the path, the fields before it are decoded by the entry type, rows that do not decode are dropped
+    while (std::getline(tableFile, line))
+    {
+        std::vector<std::string> fields;
+        boost::split(fields, line, boost::is_any_of("\t"));
+        if (fields.size() < 2 || fields.back().empty())
+        {
+            continue;
+        }
+
+        EntryType entry;
+        try
+        {
+            if (!DecodeTableRow(fields, entry))
+            {
+                continue;
+            }
+        }
+        catch (const std::exception&)
+        {
+            continue;
+        }
+        table.entries[boost::locale::conv::utf_to_utf<wchar_t>(fields.back())] = entry;
+    }
+}
+
+// function to save a persistent table to disk if any row was changed since it was loaded
+template<typename EntryType>
+bool SavePersistentTable(PersistentTable<EntryType>& table)
+{
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (!table.dirty || table.tableFilePath.empty())
+    {
+        return true;
+    }
+
+    // the table is written through a temporary file, so a crash while saving leaves the previous table intact
+    std::ostringstream tableContent;
+    tableContent << table.header << "\n";
+    for (const auto& entry : table.entries)
+    {
+        EncodeTableRow(tableContent, entry.second);
+        tableContent << "\t" << boost::locale::conv::utf_to_utf<char>(entry.first) << "\n";
+    }
+
+    std::string content = tableContent.str();
+    if (!WriteWholeFile(table.tableFilePath, nullptr, 0, content.data(), content.size()))
+    {
+        return false;
+    }
+
+    table.dirty = false;
+    return true;
+}
+
+// function to discard every row of a persistent table, both in memory and on disk
+template<typename EntryType>
+void ResetPersistentTable(PersistentTable<EntryType>& table)
+{
+    std::lock_guard<std::mutex> lock(table.mutex);
+    table.entries.clear();
+    table.dirty = false;
+
+    boost::system::error_code ec;
+    boost::filesystem::remove(boost::filesystem::path(table.tableFilePath), ec);
+}
+
+// structure to hold a cached checksum together with the file metadata it was calculated for
+struct HashCacheEntry
+{
+    unsigned long long fileSize = 0;
+    unsigned long long lastWriteTime = 0;
+    std::string digest;
+};
+
+// function to decode a hash cache row, stored as digest, size, last write time and path
+bool DecodeTableRow(const std::vector<std::string>& fields, HashCacheEntry& entry)
+{
+    if (fields.size() != 4 || fields[0].empty())
+    {
+        return false;
+    }
+    entry.digest = fields[0];
+    entry.fileSize = std::stoull(fields[1]);
+    entry.lastWriteTime = std::stoull(fields[2]);
+    return true;
+}
+
+// function to encode a hash cache row without its path
+void EncodeTableRow(std::ostream& row, const HashCacheEntry& entry)
+{
+    row << entry.digest << "\t" << entry.fileSize << "\t" << entry.lastWriteTime;
+}
+
+// global hash cache shared by every checksum calculation
+PersistentTable<HashCacheEntry> hashCache("DOW2LauncherHashCache 1 md5");
+
+// function to load the hash cache from disk
+void LoadHashCache(const std::wstring& cacheFilePath)
+{
+    TRACE_SCOPE("LoadHashCache");
+    LoadPersistentTable(hashCache, cacheFilePath);
+}
+
+// function to save the hash cache to disk if any checksum was added since it was loaded
+bool SaveHashCache()
+{
+    TRACE_SCOPE("SaveHashCache");
+    return SavePersistentTable(hashCache);
+}
+
+// function to discard every cached checksum, both in memory and on disk
+void ResetHashCache()
+{
+    ResetPersistentTable(hashCache);
+}
+
+// function to look up the cached MD5 checksum of a file without hashing it, only valid while the file's size and last write time are unchanged
+bool LookupCachedMD5(const wchar_t* filepath, unsigned long long fileSize, unsigned long long lastWriteTime, std::string& md5String)
+{
+    std::wstring cacheKey = GetFilePathKey(filepath);
+    std::lock_guard<std::mutex> lock(hashCache.mutex);
+    auto it = hashCache.entries.find(cacheKey);
+    if (it != hashCache.entries.end() && it->second.fileSize == fileSize && it->second.lastWriteTime == lastWriteTime)
+    {
+        md5String = it->second.digest;
+        return true;
+    }
+    return false;
+}
+
+// function to store the MD5 checksum of a file in the cache, together with the file metadata it was calculated for
+void StoreCachedMD5(const wchar_t* filepath, unsigned long long fileSize, unsigned long long lastWriteTime, const std::string& md5String)
+{
+    std::wstring cacheKey = GetFilePathKey(filepath);
+    std::lock_guard<std::mutex> lock(hashCache.mutex);
+    HashCacheEntry& entry = hashCache.entries[cacheKey];
+    entry.fileSize = fileSize;
+    entry.lastWriteTime = lastWriteTime;
+    entry.digest = md5String;
+    hashCache.dirty = true;
+}
+
+// function to calculate the MD5 checksum of a file, reusing the cached checksum while the file's size and last write time are unchanged
+bool CalculateMD5Cached(const wchar_t* filepath, std::string& md5String)
+{
+    unsigned long long fileSize = 0;
+    unsigned long long lastWriteTime = 0;
+    if (!GetFileMetadata(filepath, fileSize, lastWriteTime))
+    {
+        return false;
+    }
+
+    if (LookupCachedMD5(filepath, fileSize, lastWriteTime, md5String))
+    {
+        return true;
+    }
+
+    if (!CalculateMD5(filepath, md5String))
+    {
+        return false;
+    }
+
+    // the metadata read before hashing is stored, so a file modified while it was being hashed is hashed again next time
+    StoreCachedMD5(filepath, fileSize, lastWriteTime, md5String);
+    return true;
+}
+
+// structure to hold an archive verified on an earlier launch together with the metadata and header digest it was verified with
+struct ArchiveManifestEntry
+{
+    unsigned long long fileSize = 0;
+    unsigned long long lastWriteTime = 0;
+    std::string headerDigest;
+    SgaVerificationLevel level = SgaVerificationLevel::None;
+};
+
+// function to decode an archive manifest row, stored as verification level, header digest, size, last write time and path
+bool DecodeTableRow(const std::vector<std::string>& fields, ArchiveManifestEntry& entry)
+{
+    if (fields.size() != 5 || fields[1].empty() || !ParseSgaVerificationLevel(boost::locale::conv::utf_to_utf<wchar_t>(fields[0]), entry.level))
+    {
+        return false;
+    }
+    entry.headerDigest = fields[1];
+    entry.fileSize = std::stoull(fields[2]);
+    entry.lastWriteTime = std::stoull(fields[3]);
+    return true;
+}
+
+// function to encode an archive manifest row without its path
+void EncodeTableRow(std::ostream& row, const ArchiveManifestEntry& entry)
+{
+    row << boost::locale::conv::utf_to_utf<char>(std::wstring(GetSgaVerificationLevelName(entry.level))) << "\t" << entry.headerDigest << "\t" << entry.fileSize << "\t" << entry.lastWriteTime;
+}
+
+// global archive manifest, archives whose metadata is unchanged since they were verified are not verified again
+PersistentTable<ArchiveManifestEntry> archiveManifest("DOW2LauncherArchiveManifest 1 xxh64");
+
+// function to load the archive manifest from disk
+void LoadArchiveManifest(const std::wstring& manifestFilePath)
+{
+    TRACE_SCOPE("LoadArchiveManifest");
+    LoadPersistentTable(archiveManifest, manifestFilePath);
+}
+
+// function to save the archive manifest to disk if any archive was verified since it was loaded
+bool SaveArchiveManifest()
+{
+    TRACE_SCOPE("SaveArchiveManifest");
+    return SavePersistentTable(archiveManifest);
+}
+
+// function to discard every verified archive, both in memory and on disk
+void ResetArchiveManifest()
+{
+    ResetPersistentTable(archiveManifest);
+}
+
+// function to check whether an archive was verified at a level at least as thorough as requested, and is unchanged since
+bool IsArchiveVerified(const wchar_t* filepath, unsigned long long fileSize, unsigned long long lastWriteTime, const std::string& headerDigest, SgaVerificationLevel level)
+{
+    std::wstring manifestKey = GetFilePathKey(filepath);
+    std::lock_guard<std::mutex> lock(archiveManifest.mutex);
+    auto it = archiveManifest.entries.find(manifestKey);
+    return it != archiveManifest.entries.end() && it->second.fileSize == fileSize && it->second.lastWriteTime == lastWriteTime &&
+        it->second.headerDigest == headerDigest && static_cast<int>(it->second.level) >= static_cast<int>(level);
+}
+
+// function to record a verified archive in the manifest, an unchanged archive keeps the most thorough level it was verified at
+void StoreVerifiedArchive(const wchar_t* filepath, unsigned long long fileSize, unsigned long long lastWriteTime, const std::string& headerDigest, SgaVerificationLevel level)
+{
+    if (IsArchiveVerified(filepath, fileSize, lastWriteTime, headerDigest, level))
+    {
+        return;
+    }
+
+    std::wstring manifestKey = GetFilePathKey(filepath);
+    std::lock_guard<std::mutex> lock(archiveManifest.mutex);
+    ArchiveManifestEntry& entry = archiveManifest.entries[manifestKey];
+    entry.fileSize = fileSize;
+    entry.lastWriteTime = lastWriteTime;
+    entry.headerDigest = headerDigest;
+    entry.level = level;
+    archiveManifest.dirty = true;
+}
+
+// function to run a task for every index in a range on a bounded pool of worker threads
+void ParallelFor(size_t count, const std::function<void(size_t)>& task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    unsigned int workerCount = std::thread::hardware_concurrency();
+    if (workerCount == 0)
+    {
+        workerCount = 1;
+    }
+    workerCount = (std::min)(workerCount, static_cast<unsigned int>(MAX_WORKER_THREADS));
+    if (count < workerCount)
+    {
+        workerCount = static_cast<unsigned int>(count);
+    }
+
+    std::atomic<size_t> nextIndex(0);
+    auto worker = [&]()
+    {
+        size_t index;
+        while ((index = nextIndex++) < count)
+        {
+            task(index);
+        }
+    };
+
+    // the calling thread takes part in the work, so only the remaining workers are spawned
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < workerCount; ++i)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+
+    for (auto& workerThread : workers)
+    {
+        workerThread.join();
+    }
+}
+
+// structure to hold a file and the .bin baseline it is verified against
+struct FilePairCheck
+{
+    std::wstring filePath;
+    std::wstring baselinePath;
+    bool fileReadable = false;
+    bool baselineReadable = false;
+    bool filesMatch = false;
+};
+
+// function to compare a file with its baseline, rejecting a mismatch from the file sizes or sampled contents before falling back to full MD5 checksums
+void CompareFilePair(FilePairCheck& check)
+{
+    unsigned long long fileSize = 0;
+    unsigned long long fileWriteTime = 0;
+    unsigned long long baselineSize = 0;
+    unsigned long long baselineWriteTime = 0;
+    check.baselineReadable = GetFileMetadata(check.baselinePath.c_str(), baselineSize, baselineWriteTime);
+    check.fileReadable = GetFileMetadata(check.filePath.c_str(), fileSize, fileWriteTime);
+    check.filesMatch = false;
+    if (!check.baselineReadable || !check.fileReadable)
+    {
+        return;
+    }
+
+    // checksums cached from an earlier launch settle the comparison without reading either file
+    std::string fileMD5;
+    std::string baselineMD5;
+    if (LookupCachedMD5(check.baselinePath.c_str(), baselineSize, baselineWriteTime, baselineMD5) &&
+        LookupCachedMD5(check.filePath.c_str(), fileSize, fileWriteTime, fileMD5))
+    {
+        check.filesMatch = fileMD5 == baselineMD5;
+        return;
+    }
+
+    if (fileSize != baselineSize)
+    {
+        return;
+    }
+
+    // a failed sample read falls through to hashing, which decides whether either file is readable
+    bool samplesMatch = false;
+    bool samplesCoverFile = false;
+    if (CompareFileSamples(check.filePath.c_str(), check.baselinePath.c_str(), fileSize, samplesMatch, samplesCoverFile))
+    {
+        if (!samplesMatch || samplesCoverFile)
+        {
+            check.filesMatch = samplesMatch;
+            return;
+        }
+    }
+
+    check.baselineReadable = CalculateMD5Cached(check.baselinePath.c_str(), baselineMD5);
+    check.fileReadable = CalculateMD5Cached(check.filePath.c_str(), fileMD5);
+    check.filesMatch = check.baselineReadable && check.fileReadable && fileMD5 == baselineMD5;
+}
+
+// function to compare a file with its baseline now
+FilePairCheck CheckFilePair(const std::wstring& filePath, const std::wstring& baselinePath)
+{
+    FilePairCheck check;
+    check.filePath = filePath;
+    check.baselinePath = baselinePath;
+    CompareFilePair(check);
+    return check;
+}
+
+// function to compare many file pairs on a bounded pool of worker threads
+void CompareFilePairsParallel(std::vector<FilePairCheck>& checks)
+{
+    TRACE_SCOPE("CompareFilePairsParallel");
+    ParallelFor(checks.size(), [&checks](size_t index)
+        {
+            CompareFilePair(checks[index]);
+        });
+}
+
+// structure to hold a file of an SGA archive whose stored data is verified against the CRC-32 in its preamble
+struct SgaVerifyFile
+{
+    std::string name;
+    uint64_t dataOffset = 0;
+    uint32_t size = 0;
+    uint32_t expectedCrc = 0;
+    bool hasPreamble = false; // set when the preamble names the file, files without one cannot be verified
+    size_t firstSegment = 0;
+    size_t segmentCount = 0;
+};
+
+// structure to hold a range of one file's stored data, hashed on its own and combined in order afterwards
+struct SgaVerifySegment
+{
+    size_t fileIndex = 0;
+    uint64_t offset = 0;
+    size_t length = 0;
+    uint32_t crc = 0;
+};
+
+// structure to hold a run of consecutive segments handed to one worker as a fixed-size chunk
+struct SgaVerifyChunk
+{
+    size_t firstSegment = 0;
+    size_t segmentCount = 0;
+    bool readFailed = false;
+};
+
+// function to hash the segments of one chunk, reading the preamble of every file that starts in it
+void VerifySgaChunk(const wchar_t* filepath, std::vector<SgaVerifyFile>& files, std::vector<SgaVerifySegment>& segments, SgaVerifyChunk& chunk)
+{
+    TRACE_SCOPE("VerifySgaChunk", filepath);
+    PortableFile file;
+    if (!OpenPortableFile(filepath, file))
+    {
+        chunk.readFailed = true;
+        return;
+    }
+
+    AlignedReadBuffer buffer;
+    AllocateReadBuffer(buffer, HASH_READ_BUFFER_SIZE);
+
+    for (size_t i = chunk.firstSegment; i < chunk.firstSegment + chunk.segmentCount && !chunk.readFailed; ++i)
+    {
+        SgaVerifySegment& segment = segments[i];
+        SgaVerifyFile& verifyFile = files[segment.fileIndex];
+
+        // only the chunk holding a file's first segment touches its preamble, so no two workers write the same file
+        if (segment.offset == verifyFile.dataOffset)
+        {
+            unsigned char preamble[SGA_PREAMBLE_SIZE];
+            if (!ReadPortableFileExactAt(file, verifyFile.dataOffset - SGA_PREAMBLE_SIZE, preamble, SGA_PREAMBLE_SIZE))
+            {
+                chunk.readFailed = true;
+                break;
+            }
+            verifyFile.hasPreamble = ReadSgaFilePreamble(preamble, verifyFile.name, verifyFile.expectedCrc);
+        }
+
+        uint32_t crc = 0;
+        uint64_t offset = segment.offset;
+        size_t remaining = segment.length;
+        while (remaining > 0)
+        {
+            size_t readSize = (std::min)(remaining, buffer.size);
+            if (!ReadPortableFileExactAt(file, offset, buffer.data, readSize))
+            {
+                chunk.readFailed = true;
+                break;
+            }
+            crc = UpdateCRC32(crc, buffer.data, readSize);
+            offset += readSize;
+            remaining -= readSize;
+        }
+        segment.crc = crc;
+    }
+
+    ClosePortableFile(file);
+}
+
+// function to verify the stored data of every file in an SGA archive against the CRC-32 in its preamble, split into fixed-size chunks hashed in parallel
+bool VerifySgaArchiveContents(const wchar_t* filepath, std::wstring& problem)
+{
+    TRACE_SCOPE("VerifySgaArchiveContents", filepath);
+    MappedFile archive;
+    SgaArchiveInfo info;
+    if (!MapSgaArchiveHeader(filepath, archive, info, problem))
+    {
+        return false;
+    }
+
+    // only version 5 archives store a checksum in front of each file
+    if (!info.knownLayout || info.versionMajor != 5)
+    {
+        UnmapPortableFile(archive);
+        return true;
+    }
+
+    std::vector<SgaVerifyFile> files;
+    files.reserve(info.fileTable.count);
+    for (size_t i = 0; i < info.fileTable.count; ++i)
+    {
+        SgaFileEntry entry;
+        GetSgaFileEntry(archive, info, i, entry);
+
+        SgaVerifyFile verifyFile;
+        if (entry.compressedSize == 0 || entry.dataOffset < info.dataOffset + SGA_PREAMBLE_SIZE ||
+            !RangeFits(entry.dataOffset, entry.compressedSize, archive.fileSize) || !GetSgaFileName(archive, info, entry, verifyFile.name))
+        {
+            continue;
+        }
+        verifyFile.dataOffset = entry.dataOffset;
+        verifyFile.size = entry.compressedSize;
+        files.push_back(verifyFile);
+    }
+    UnmapPortableFile(archive);
+
+    // files are hashed in the order they are stored, so the workers move through the archive together
+    std::sort(files.begin(), files.end(), [](const SgaVerifyFile& first, const SgaVerifyFile& second)
+        {
+            return first.dataOffset < second.dataOffset;
+        });
+
+    // large files are split and small files are grouped, so every chunk holds about the same amount of data
+    std::vector<SgaVerifySegment> segments;
+    std::vector<SgaVerifyChunk> chunks;
+    size_t chunkBytes = 0;
+    for (size_t fileIndex = 0; fileIndex < files.size(); ++fileIndex)
+    {
+        SgaVerifyFile& verifyFile = files[fileIndex];
+        verifyFile.firstSegment = segments.size();
+
+        uint64_t offset = verifyFile.dataOffset;
+        size_t remaining = verifyFile.size;
+        while (remaining > 0)
+        {
+            if (chunks.empty() || chunkBytes >= SGA_VERIFY_CHUNK_SIZE)
+            {
+                SgaVerifyChunk chunk;
+                chunk.firstSegment = segments.size();
+                chunks.push_back(chunk);
+                chunkBytes = 0;
+            }
+
+            SgaVerifySegment segment;
+            segment.fileIndex = fileIndex;
+            segment.offset = offset;
+            segment.length = (std::min)(remaining, static_cast<size_t>(SGA_VERIFY_CHUNK_SIZE) - chunkBytes);
+            segments.push_back(segment);
+            chunks.back().segmentCount++;
+
+            chunkBytes += segment.length;
+            offset += segment.length;
+            remaining -= segment.length;
+        }
+        verifyFile.segmentCount = segments.size() - verifyFile.firstSegment;
+    }
+
+    ParallelFor(chunks.size(), [filepath, &files, &segments, &chunks](size_t index)
+        {
+            VerifySgaChunk(filepath, files, segments, chunks[index]);
+        });
+
+    for (const auto& chunk : chunks)
+    {
+        if (chunk.readFailed)
+        {
+            problem = L"the file could not be read";
+            return false;
+        }
+    }
+
+    size_t damagedFiles = 0;
+    std::string firstDamagedFile;
+    for (const auto& verifyFile : files)
+    {
+        if (!verifyFile.hasPreamble)
+        {
+            continue;
+        }
+
+        uint32_t crc = segments[verifyFile.firstSegment].crc;
+        for (size_t i = verifyFile.firstSegment + 1; i < verifyFile.firstSegment + verifyFile.segmentCount; ++i)
+        {
+            crc = CombineCRC32(crc, segments[i].crc, segments[i].length);
+        }
+        if (crc != verifyFile.expectedCrc)
+        {
+            if (damagedFiles == 0)
+            {
+                firstDamagedFile = verifyFile.name;
+            }
+            ++damagedFiles;
+        }
+    }
+
+    if (damagedFiles > 0)
+    {
+        problem = std::to_wstring(damagedFiles) + L" stored file(s) do not match their checksum, the first is " + boost::locale::conv::utf_to_utf<wchar_t>(firstDamagedFile);
+        return false;
+    }
+    return true;
+}
+
+// results of restoring a file from its .bin baseline
+enum class RestoreResult
+{
+    Restored,
+    CopyFailed, // the baseline could not be read, or the restored file could not be written
+    Mismatched // the data read from the baseline did not match its size or its cached checksum, the target was left untouched
+};
+
+// function to restore a file from its baseline, hashing the baseline in the same pass that writes a temporary file next to the target, and renaming it over the target once the copy is verified
+RestoreResult RestoreFileFromBaseline(const std::wstring& baselinePath, const std::wstring& filePath)
+{
+    unsigned long long baselineSize = 0;
+    unsigned long long baselineWriteTime = 0;
+    if (!GetFileMetadata(baselinePath.c_str(), baselineSize, baselineWriteTime))
+    {
+        return RestoreResult::CopyFailed;
+    }
+
+    // the baseline is only read once, so its checksum is checked against the cache when an earlier comparison already hashed it
+    std::string expectedMD5;
+    bool expectedKnown = LookupCachedMD5(baselinePath.c_str(), baselineSize, baselineWriteTime, expectedMD5);
+
+    std::wstring tempFilePath = filePath + L".tmp";
+    std::string streamedMD5;
+    unsigned long long bytesCopied = 0;
+    if (!CopyFileHashed(baselinePath.c_str(), tempFilePath.c_str(), HashAlgorithm::MD5, streamedMD5, bytesCopied))
+    {
+        DeletePortableFile(tempFilePath.c_str());
+        return RestoreResult::CopyFailed;
+    }
+
+    // the copy is flushed by now, a baseline that changed while it was copied shows up in its size or its metadata
+    unsigned long long copiedSize = 0;
+    unsigned long long copiedWriteTime = 0;
+    bool baselineUnchanged = GetFileMetadata(baselinePath.c_str(), copiedSize, copiedWriteTime) && copiedSize == baselineSize && copiedWriteTime == baselineWriteTime;
+    if (bytesCopied != baselineSize || !baselineUnchanged || (expectedKnown && streamedMD5 != expectedMD5))
+    {
+        DeletePortableFile(tempFilePath.c_str());
+        return RestoreResult::Mismatched;
+    }
+
+    if (!ReplacePortableFile(tempFilePath.c_str(), filePath.c_str()))
+    {
+        DeletePortableFile(tempFilePath.c_str());
+        return RestoreResult::CopyFailed;
+    }
+    InvalidateDirectoryCache(filePath);
+
+    // the streamed checksum belongs to both files, so the next comparison of this pair is settled from the cache
+    if (!expectedKnown)
+    {
+        StoreCachedMD5(baselinePath.c_str(), baselineSize, baselineWriteTime, streamedMD5);
+    }
+    unsigned long long fileSize = 0;
+    unsigned long long fileWriteTime = 0;
+    if (GetFileMetadata(filePath.c_str(), fileSize, fileWriteTime))
+    {
+        StoreCachedMD5(filePath.c_str(), fileSize, fileWriteTime, streamedMD5);
+    }
+    return RestoreResult::Restored;
+}
+
+// encodings a text file can be stored in, detected from its byte order mark
+enum class TextEncoding
+{
+    UTF8,
+    UTF8BOM,
+    UTF16LE,
+    UTF16BE
+};
+
+// function to read a whole file into memory with a single read
+bool ReadWholeFile(const std::wstring& filePath, std::string& content)
+{
+    unsigned long long fileSize = 0;
+    unsigned long long lastWriteTime = 0;
+    if (!GetFileMetadata(filePath.c_str(), fileSize, lastWriteTime))
+    {
+        return false;
+    }
+
+    PortableFile file;
+    if (!OpenPortableFile(filePath.c_str(), file))
+    {
+        return false;
+    }
+
+    content.resize(static_cast<size_t>(fileSize));
+    bool success = ReadPortableFileExactAt(file, 0, &content[0], content.size());
+    ClosePortableFile(file);
+    return success;
+}
+
+// function to detect the encoding of a text file from its byte order mark, text without one is assumed to be UTF-8
+TextEncoding DetectTextEncoding(const std::string& rawContent)
+{
+    if (rawContent.size() >= 2 && rawContent[0] == char(0xFF) && rawContent[1] == char(0xFE))
+    {
+        return TextEncoding::UTF16LE;
+    }
+    if (rawContent.size() >= 2 && rawContent[0] == char(0xFE) && rawContent[1] == char(0xFF))
+    {
+        return TextEncoding::UTF16BE;
+    }
+    if (rawContent.size() >= 3 && rawContent[0] == char(0xEF) && rawContent[1] == char(0xBB) && rawContent[2] == char(0xBF))
+    {
+        return TextEncoding::UTF8BOM;
+    }
+    return TextEncoding::UTF8;
+}
+
+// function to decode text to UTF-16 without its byte order mark, throws boost::locale::conv::conversion_error on invalid UTF-8
+void DecodeToUTF16(const std::string& rawContent, TextEncoding encoding, std::u16string& content)
+{
+    switch (encoding)
+    {
+    case TextEncoding::UTF16LE:
+    case TextEncoding::UTF16BE:
+    {
+        content.resize((rawContent.size() - 2) / 2);
+        memcpy(&content[0], rawContent.data() + 2, content.size() * sizeof(char16_t));
+        if (encoding == TextEncoding::UTF16BE)
+        {
+            // swap bytes to convert from BE to LE
+            for (char16_t& ch : content)
+            {
+                ch = static_cast<char16_t>((ch >> 8) | (ch << 8));
+            }
+        }
+        break;
+    }
+    default:
+    {
+        const char* begin = rawContent.data() + (encoding == TextEncoding::UTF8BOM ? 3 : 0);
+        const char* end = rawContent.data() + rawContent.size();
+        bool isASCII = false;
+        if (!IsValidUTF8(begin, end, isASCII))
+        {
+            throw boost::locale::conv::conversion_error();
+        }
+
+        // plain ASCII is widened directly, anything else goes through the full decoder
+        if (isASCII)
+        {
+            content.assign(begin, end);
+        }
+        else
+        {
+            content = boost::locale::conv::utf_to_utf<char16_t>(begin, end, boost::locale::conv::stop);
+        }
+        break;
+    }
+    }
+}
+
+// function to convert bare CR and LF line breaks to CRLF, returns whether anything had to be converted
+bool NormalizeToCRLF(std::u16string& content)
+{
+    const char16_t* begin = content.data();
+    const char16_t* end = begin + content.size();
+    size_t bareBreaks = CountBareLineBreaks(begin, end);
+    if (bareBreaks == 0)
+    {
+        return false;
+    }
+
+    std::u16string convertedContent = ConvertToCRLF(begin, end, bareBreaks);
+    content.swap(convertedContent);
+    return true;
+}
+
+// function to write text as UTF-16 LE with a byte order mark, through a temporary file renamed over the target
+bool WriteUTF16LEFile(const std::wstring& filePath, const std::u16string& content)
+{
+    const unsigned char bom[2] = { 0xFF, 0xFE };
+    return WriteWholeFile(filePath, bom, sizeof(bom), content.data(), content.size() * sizeof(char16_t));
+}
+
+// function to verify that a text file uses Windows (CRLF) line breaks, converting it in its own encoding if it does not, and to return the resulting text decoded to UTF-16
+bool CheckAndConvertToWindowsCRLF(const std::wstring& fileName, std::u16string& content)
+{
+    TRACE_SCOPE("CheckAndConvertToWindowsCRLF", fileName);
+    std::string rawContent;
+    if (!ReadWholeFile(fileName, rawContent))
+    {
+        return false;
+    }
+
+    TextEncoding encoding = DetectTextEncoding(rawContent);
+    if (encoding == TextEncoding::UTF16LE || encoding == TextEncoding::UTF16BE)
+    {
+        DecodeToUTF16(rawContent, encoding, content);
+        const char16_t* begin = content.data();
+        const char16_t* end = begin + content.size();
+        if (!IsValidUTF16(begin, end))
+        {
+            return false;
+        }
+
+        size_t bareBreaks = CountBareLineBreaks(begin, end);
+        if (bareBreaks == 0)
+        {
+            return true; // file is already in CRLF format
+        }
+
+        content = ConvertToCRLF(begin, end, bareBreaks);
+        std::u16string encodedContent = content;
+        if (encoding == TextEncoding::UTF16BE)
+        {
+            // swap bytes to convert back from LE to BE
+            for (char16_t& ch : encodedContent)
+            {
+                ch = static_cast<char16_t>((ch >> 8) | (ch << 8));
+            }
+        }
+        return WriteWholeFile(fileName, rawContent.data(), 2, encodedContent.data(), encodedContent.size() * sizeof(char16_t));
+    }
+
+    // line breaks are single bytes in UTF-8, so the raw bytes are scanned and converted without decoding them
+    size_t bomSize = (encoding == TextEncoding::UTF8BOM) ? 3 : 0;
+    const char* begin = rawContent.data() + bomSize;
+    const char* end = rawContent.data() + rawContent.size();
+    bool isASCII = false;
+    if (!IsValidUTF8(begin, end, isASCII))
+    {
+        return false;
+    }
+
+    size_t bareBreaks = CountBareLineBreaks(begin, end);
+    if (bareBreaks == 0)
+    {
+        // file is already in CRLF format
+        DecodeToUTF16(rawContent, encoding, content);
+        return true;
+    }
+
+    std::string convertedContent = ConvertToCRLF(begin, end, bareBreaks);
+    DecodeToUTF16(convertedContent, TextEncoding::UTF8, content);
+    return WriteWholeFile(fileName, rawContent.data(), bomSize, convertedContent.data(), convertedContent.size());
 }
\ No newline at end of file
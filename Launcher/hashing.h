@@ -0,0 +1,1087 @@
+// header for the portable streaming hash functions used by the file integrity checks, kept free of any platform crypto API
+
+#pragma once
+
+#define HASH_READ_BUFFER_SIZE (1024 * 1024) // size of the buffer files are streamed through while hashing
+#define HASH_READ_BUFFER_ALIGNMENT 4096 // alignment of the read buffer, matching the usual page and sector size
+#define FILE_COMPARE_SAMPLE_SIZE (64 * 1024) // size of the prefix and suffix sampled when comparing two files before hashing them
+
+// standard library headers
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+// boost headers
+#include <boost/predef/os.h>
+#include <boost/locale/encoding_utf.hpp>
+
+// launcher headers
+#include "trace.h"
+
+// platform headers
+#if BOOST_OS_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <cerrno>
+#endif
+
+// hash algorithms available to the file integrity checks
+enum class HashAlgorithm
+{
+    MD5, // kept for compatibility with the MD5 checksums the launcher has always used
+    XXH64 // non-cryptographic, several times faster than MD5 for large files
+};
+
+
+
+//
+//
+//
+// PORTABLE FILE ACCESS
+//
+//
+//
+
+
+
+// structure to hold an open file handle on either platform
+struct PortableFile
+{
+#if BOOST_OS_WINDOWS
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+};
+
+// function to open a file for sequential reading
+bool OpenPortableFile(const wchar_t* filepath, PortableFile& file)
+{
+#if BOOST_OS_WINDOWS
+    file.handle = CreateFileW(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    return file.handle != INVALID_HANDLE_VALUE;
+#else
+    std::string path = boost::locale::conv::utf_to_utf<char>(std::wstring(filepath));
+    file.fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file.fd < 0)
+    {
+        return false;
+    }
+    posix_fadvise(file.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return true;
+#endif
+}
+
+// function to read the next chunk of a file, bytesRead is zero at the end of the file
+bool ReadPortableFile(PortableFile& file, void* buffer, size_t size, size_t& bytesRead)
+{
+#if BOOST_OS_WINDOWS
+    DWORD chunkRead = 0;
+    DWORD chunkSize = size > 0x7FFFFFFF ? 0x7FFFFFFF : static_cast<DWORD>(size);
+    if (!ReadFile(file.handle, buffer, chunkSize, &chunkRead, NULL))
+    {
+        bytesRead = 0;
+        return false;
+    }
+    bytesRead = chunkRead;
+    return true;
+#else
+    ssize_t chunkRead;
+    do
+    {
+        chunkRead = read(file.fd, buffer, size);
+    }
+    while (chunkRead < 0 && errno == EINTR);
+
+    if (chunkRead < 0)
+    {
+        bytesRead = 0;
+        return false;
+    }
+    bytesRead = static_cast<size_t>(chunkRead);
+    return true;
+#endif
+}
+
+// function to read a chunk of a file at an offset, independent of the current file position
+bool ReadPortableFileAt(PortableFile& file, unsigned long long offset, void* buffer, size_t size, size_t& bytesRead)
+{
+#if BOOST_OS_WINDOWS
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD chunkRead = 0;
+    DWORD chunkSize = size > 0x7FFFFFFF ? 0x7FFFFFFF : static_cast<DWORD>(size);
+    if (!ReadFile(file.handle, buffer, chunkSize, &chunkRead, &overlapped))
+    {
+        bytesRead = 0;
+        return GetLastError() == ERROR_HANDLE_EOF;
+    }
+    bytesRead = chunkRead;
+    return true;
+#else
+    ssize_t chunkRead;
+    do
+    {
+        chunkRead = pread(file.fd, buffer, size, static_cast<off_t>(offset));
+    }
+    while (chunkRead < 0 && errno == EINTR);
+
+    if (chunkRead < 0)
+    {
+        bytesRead = 0;
+        return false;
+    }
+    bytesRead = static_cast<size_t>(chunkRead);
+    return true;
+#endif
+}
+
+// function to fill a buffer from a file at an offset, failing if the file ends before the buffer is full
+bool ReadPortableFileExactAt(PortableFile& file, unsigned long long offset, void* buffer, size_t size)
+{
+    unsigned char* destination = static_cast<unsigned char*>(buffer);
+    while (size > 0)
+    {
+        size_t bytesRead = 0;
+        if (!ReadPortableFileAt(file, offset, destination, size, bytesRead) || bytesRead == 0)
+        {
+            return false;
+        }
+        destination += bytesRead;
+        offset += bytesRead;
+        size -= bytesRead;
+    }
+    return true;
+}
+
+// function to create or truncate a file for sequential writing
+bool CreatePortableFile(const wchar_t* filepath, PortableFile& file)
+{
+#if BOOST_OS_WINDOWS
+    file.handle = CreateFileW(filepath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    return file.handle != INVALID_HANDLE_VALUE;
+#else
+    std::string path = boost::locale::conv::utf_to_utf<char>(std::wstring(filepath));
+    file.fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    return file.fd >= 0;
+#endif
+}
+
+// function to write a whole buffer to a file opened with CreatePortableFile
+bool WritePortableFile(PortableFile& file, const void* buffer, size_t size)
+{
+    const unsigned char* source = static_cast<const unsigned char*>(buffer);
+    while (size > 0)
+    {
+#if BOOST_OS_WINDOWS
+        DWORD chunkWritten = 0;
+        DWORD chunkSize = size > 0x7FFFFFFF ? 0x7FFFFFFF : static_cast<DWORD>(size);
+        if (!WriteFile(file.handle, source, chunkSize, &chunkWritten, NULL) || chunkWritten == 0)
+        {
+            return false;
+        }
+#else
+        ssize_t chunkWritten = write(file.fd, source, size);
+        if (chunkWritten < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (chunkWritten <= 0)
+        {
+            return false;
+        }
+#endif
+        source += chunkWritten;
+        size -= static_cast<size_t>(chunkWritten);
+    }
+    return true;
+}
+
+// function to flush the written contents of a file to the disk
+bool FlushPortableFile(PortableFile& file)
+{
+#if BOOST_OS_WINDOWS
+    return FlushFileBuffers(file.handle) != 0;
+#else
+    return fsync(file.fd) == 0;
+#endif
+}
+
+// function to close a file opened with OpenPortableFile
+void ClosePortableFile(PortableFile& file)
+{
+#if BOOST_OS_WINDOWS
+    if (file.handle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file.handle);
+        file.handle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (file.fd >= 0)
+    {
+        close(file.fd);
+        file.fd = -1;
+    }
+#endif
+}
+
+// function to atomically replace a file with another file in the same directory
+bool ReplacePortableFile(const wchar_t* sourcePath, const wchar_t* targetPath)
+{
+#if BOOST_OS_WINDOWS
+    return MoveFileExW(sourcePath, targetPath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    std::string source = boost::locale::conv::utf_to_utf<char>(std::wstring(sourcePath));
+    std::string target = boost::locale::conv::utf_to_utf<char>(std::wstring(targetPath));
+    if (rename(source.c_str(), target.c_str()) != 0)
+    {
+        return false;
+    }
+
+    // the directory entry is flushed as well, so the rename itself survives a crash
+    size_t separatorPos = target.find_last_of('/');
+    std::string directory = separatorPos == std::string::npos ? "." : (separatorPos == 0 ? "/" : target.substr(0, separatorPos));
+    int directoryFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directoryFd >= 0)
+    {
+        fsync(directoryFd);
+        close(directoryFd);
+    }
+    return true;
+#endif
+}
+
+// function to delete a file, ignoring a file that does not exist
+void DeletePortableFile(const wchar_t* filepath)
+{
+#if BOOST_OS_WINDOWS
+    DeleteFileW(filepath);
+#else
+    std::string path = boost::locale::conv::utf_to_utf<char>(std::wstring(filepath));
+    unlink(path.c_str());
+#endif
+}
+
+// function to get the size and last write time of a file
+bool GetFileMetadata(const wchar_t* filepath, unsigned long long& fileSize, unsigned long long& lastWriteTime)
+{
+#if BOOST_OS_WINDOWS
+    WIN32_FILE_ATTRIBUTE_DATA fileData;
+    if (!GetFileAttributesExW(filepath, GetFileExInfoStandard, &fileData) || (fileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        return false;
+    }
+
+    fileSize = (static_cast<unsigned long long>(fileData.nFileSizeHigh) << 32) | fileData.nFileSizeLow;
+    lastWriteTime = (static_cast<unsigned long long>(fileData.ftLastWriteTime.dwHighDateTime) << 32) | fileData.ftLastWriteTime.dwLowDateTime;
+    return true;
+#else
+    std::string path = boost::locale::conv::utf_to_utf<char>(std::wstring(filepath));
+    struct stat fileStat;
+    if (stat(path.c_str(), &fileStat) != 0 || !S_ISREG(fileStat.st_mode))
+    {
+        return false;
+    }
+
+    fileSize = static_cast<unsigned long long>(fileStat.st_size);
+    lastWriteTime = static_cast<unsigned long long>(fileStat.st_mtim.tv_sec) * 1000000000ULL + static_cast<unsigned long long>(fileStat.st_mtim.tv_nsec);
+    return true;
+#endif
+}
+
+// structure to hold a read-only view of a file mapped into memory
+struct MappedFile
+{
+    const unsigned char* data = nullptr;
+    size_t size = 0; // size of the view
+    unsigned long long fileSize = 0; // size of the whole file, larger than the view when only a prefix is mapped
+};
+
+// function to map a file into memory for reading, only the first maxLength bytes when maxLength is not zero, an empty file maps to an empty view
+bool MapPortableFile(const wchar_t* filepath, MappedFile& mappedFile, size_t maxLength = 0)
+{
+    mappedFile.data = nullptr;
+    mappedFile.size = 0;
+    mappedFile.fileSize = 0;
+
+    PortableFile file;
+    if (!OpenPortableFile(filepath, file))
+    {
+        return false;
+    }
+
+#if BOOST_OS_WINDOWS
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file.handle, &fileSize))
+    {
+        ClosePortableFile(file);
+        return false;
+    }
+    mappedFile.fileSize = static_cast<unsigned long long>(fileSize.QuadPart);
+    if (fileSize.QuadPart == 0)
+    {
+        ClosePortableFile(file);
+        return true;
+    }
+    size_t viewSize = (maxLength != 0 && maxLength < mappedFile.fileSize) ? maxLength : static_cast<size_t>(fileSize.QuadPart);
+
+    // the view keeps the mapping and the file open, so both handles are closed straight away
+    HANDLE mapping = CreateFileMappingW(file.handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    ClosePortableFile(file);
+    if (mapping == NULL)
+    {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, viewSize);
+    CloseHandle(mapping);
+    if (view == NULL)
+    {
+        return false;
+    }
+
+    mappedFile.data = static_cast<const unsigned char*>(view);
+    mappedFile.size = viewSize;
+    return true;
+#else
+    struct stat fileStat;
+    if (fstat(file.fd, &fileStat) != 0)
+    {
+        ClosePortableFile(file);
+        return false;
+    }
+    mappedFile.fileSize = static_cast<unsigned long long>(fileStat.st_size);
+    if (fileStat.st_size == 0)
+    {
+        ClosePortableFile(file);
+        return true;
+    }
+    size_t viewSize = (maxLength != 0 && maxLength < mappedFile.fileSize) ? maxLength : static_cast<size_t>(fileStat.st_size);
+
+    void* view = mmap(NULL, viewSize, PROT_READ, MAP_PRIVATE, file.fd, 0);
+    ClosePortableFile(file);
+    if (view == MAP_FAILED)
+    {
+        return false;
+    }
+    madvise(view, viewSize, MADV_SEQUENTIAL);
+
+    mappedFile.data = static_cast<const unsigned char*>(view);
+    mappedFile.size = viewSize;
+    return true;
+#endif
+}
+
+// function to release a view created with MapPortableFile
+void UnmapPortableFile(MappedFile& mappedFile)
+{
+    if (mappedFile.data != nullptr)
+    {
+#if BOOST_OS_WINDOWS
+        UnmapViewOfFile(mappedFile.data);
+#else
+        munmap(const_cast<unsigned char*>(mappedFile.data), mappedFile.size);
+#endif
+    }
+    mappedFile.data = nullptr;
+    mappedFile.size = 0;
+    mappedFile.fileSize = 0;
+}
+
+// structure to hold a read buffer aligned for efficient unbuffered and sequential reads
+struct AlignedReadBuffer
+{
+    std::vector<unsigned char> storage;
+    unsigned char* data = nullptr;
+    size_t size = 0;
+};
+
+// function to allocate an aligned read buffer
+void AllocateReadBuffer(AlignedReadBuffer& buffer, size_t size)
+{
+    buffer.storage.resize(size + HASH_READ_BUFFER_ALIGNMENT);
+    uintptr_t address = reinterpret_cast<uintptr_t>(buffer.storage.data());
+    uintptr_t aligned = (address + HASH_READ_BUFFER_ALIGNMENT - 1) & ~static_cast<uintptr_t>(HASH_READ_BUFFER_ALIGNMENT - 1);
+    buffer.data = buffer.storage.data() + (aligned - address);
+    buffer.size = size;
+}
+
+// function to compare the prefix and suffix of two files of the same size, files no larger than both samples are compared in full
+bool CompareFileSamples(const wchar_t* firstPath, const wchar_t* secondPath, unsigned long long fileSize, bool& samplesMatch, bool& samplesCoverFile)
+{
+    samplesMatch = false;
+    samplesCoverFile = fileSize <= 2ULL * FILE_COMPARE_SAMPLE_SIZE;
+
+    PortableFile firstFile;
+    PortableFile secondFile;
+    if (!OpenPortableFile(firstPath, firstFile))
+    {
+        return false;
+    }
+    if (!OpenPortableFile(secondPath, secondFile))
+    {
+        ClosePortableFile(firstFile);
+        return false;
+    }
+
+    // the prefix and suffix are read as one range when they would overlap
+    size_t prefixSize = samplesCoverFile ? static_cast<size_t>(fileSize) : FILE_COMPARE_SAMPLE_SIZE;
+    size_t suffixSize = samplesCoverFile ? 0 : FILE_COMPARE_SAMPLE_SIZE;
+    unsigned long long suffixOffset = fileSize - suffixSize;
+
+    std::vector<unsigned char> firstSample(prefixSize + suffixSize);
+    std::vector<unsigned char> secondSample(prefixSize + suffixSize);
+    bool success = ReadPortableFileExactAt(firstFile, 0, firstSample.data(), prefixSize) &&
+        ReadPortableFileExactAt(secondFile, 0, secondSample.data(), prefixSize) &&
+        ReadPortableFileExactAt(firstFile, suffixOffset, firstSample.data() + prefixSize, suffixSize) &&
+        ReadPortableFileExactAt(secondFile, suffixOffset, secondSample.data() + prefixSize, suffixSize);
+
+    ClosePortableFile(firstFile);
+    ClosePortableFile(secondFile);
+
+    if (success)
+    {
+        samplesMatch = firstSample.empty() || memcmp(firstSample.data(), secondSample.data(), firstSample.size()) == 0;
+    }
+    return success;
+}
+
+
+
+//
+//
+//
+// HASH ALGORITHMS
+//
+//
+//
+
+
+
+// function to read a little endian 32-bit value
+uint32_t ReadLittleEndian32(const unsigned char* data)
+{
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// function to read a little endian 64-bit value
+uint64_t ReadLittleEndian64(const unsigned char* data)
+{
+    return static_cast<uint64_t>(ReadLittleEndian32(data)) | (static_cast<uint64_t>(ReadLittleEndian32(data + 4)) << 32);
+}
+
+// structure to hold the state of a streaming MD5 calculation (RFC 1321)
+struct MD5Context
+{
+    uint32_t state[4];
+    uint64_t length;
+    unsigned char buffer[64];
+    size_t bufferLength;
+};
+
+// function to process a single 64 byte block of MD5 input
+void MD5Transform(uint32_t state[4], const unsigned char block[64])
+{
+    static const uint32_t constants[64] =
+    {
+        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+        0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+        0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+        0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+        0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+        0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+        0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+    };
+    static const int shifts[64] =
+    {
+        7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+        5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+        4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+        6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+    };
+
+    uint32_t words[16];
+    for (int i = 0; i < 16; ++i)
+    {
+        words[i] = ReadLittleEndian32(block + i * 4);
+    }
+
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+
+    for (int i = 0; i < 64; ++i)
+    {
+        uint32_t f;
+        int g;
+        if (i < 16)
+        {
+            f = (b & c) | (~b & d);
+            g = i;
+        }
+        else if (i < 32)
+        {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) % 16;
+        }
+        else if (i < 48)
+        {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) % 16;
+        }
+        else
+        {
+            f = c ^ (b | ~d);
+            g = (7 * i) % 16;
+        }
+
+        f = f + a + constants[i] + words[g];
+        a = d;
+        d = c;
+        c = b;
+        b = b + ((f << shifts[i]) | (f >> (32 - shifts[i])));
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+}
+
+// function to start an MD5 calculation
+void MD5Init(MD5Context& context)
+{
+    context.state[0] = 0x67452301;
+    context.state[1] = 0xefcdab89;
+    context.state[2] = 0x98badcfe;
+    context.state[3] = 0x10325476;
+    context.length = 0;
+    context.bufferLength = 0;
+}
+
+// function to add data to an MD5 calculation
+void MD5Update(MD5Context& context, const unsigned char* data, size_t size)
+{
+    context.length += size;
+
+    if (context.bufferLength > 0)
+    {
+        size_t fill = 64 - context.bufferLength;
+        if (size < fill)
+        {
+            memcpy(context.buffer + context.bufferLength, data, size);
+            context.bufferLength += size;
+            return;
+        }
+        memcpy(context.buffer + context.bufferLength, data, fill);
+        MD5Transform(context.state, context.buffer);
+        data += fill;
+        size -= fill;
+        context.bufferLength = 0;
+    }
+
+    // whole blocks are hashed straight from the caller's buffer
+    while (size >= 64)
+    {
+        MD5Transform(context.state, data);
+        data += 64;
+        size -= 64;
+    }
+
+    if (size > 0)
+    {
+        memcpy(context.buffer, data, size);
+        context.bufferLength = size;
+    }
+}
+
+// function to finish an MD5 calculation
+void MD5Final(MD5Context& context, unsigned char digest[16])
+{
+    uint64_t bitLength = context.length * 8;
+    unsigned char padding[64] = { 0x80 };
+    size_t paddingLength = (context.bufferLength < 56) ? (56 - context.bufferLength) : (120 - context.bufferLength);
+
+    unsigned char lengthBytes[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        lengthBytes[i] = static_cast<unsigned char>(bitLength >> (8 * i));
+    }
+
+    MD5Update(context, padding, paddingLength);
+    MD5Update(context, lengthBytes, 8);
+
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            digest[i * 4 + j] = static_cast<unsigned char>(context.state[i] >> (8 * j));
+        }
+    }
+}
+
+const uint64_t XXH64_PRIME1 = 0x9E3779B185EBCA87ULL;
+const uint64_t XXH64_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t XXH64_PRIME3 = 0x165667B19E3779F9ULL;
+const uint64_t XXH64_PRIME4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t XXH64_PRIME5 = 0x27D4EB2F165667C5ULL;
+
+// structure to hold the state of a streaming XXH64 calculation
+struct XXH64Context
+{
+    uint64_t accumulators[4];
+    uint64_t seed;
+    uint64_t length;
+    unsigned char buffer[32];
+    size_t bufferLength;
+};
+
+// function to rotate a 64-bit value left
+uint64_t RotateLeft64(uint64_t value, int count)
+{
+    return (value << count) | (value >> (64 - count));
+}
+
+// function to mix one 8 byte lane into an XXH64 accumulator
+uint64_t XXH64Round(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * XXH64_PRIME2;
+    accumulator = RotateLeft64(accumulator, 31);
+    return accumulator * XXH64_PRIME1;
+}
+
+// function to merge an XXH64 accumulator into the final hash
+uint64_t XXH64MergeRound(uint64_t hash, uint64_t accumulator)
+{
+    hash ^= XXH64Round(0, accumulator);
+    return hash * XXH64_PRIME1 + XXH64_PRIME4;
+}
+
+// function to start an XXH64 calculation
+void XXH64Init(XXH64Context& context, uint64_t seed = 0)
+{
+    context.seed = seed;
+    context.accumulators[0] = seed + XXH64_PRIME1 + XXH64_PRIME2;
+    context.accumulators[1] = seed + XXH64_PRIME2;
+    context.accumulators[2] = seed;
+    context.accumulators[3] = seed - XXH64_PRIME1;
+    context.length = 0;
+    context.bufferLength = 0;
+}
+
+// function to add data to an XXH64 calculation
+void XXH64Update(XXH64Context& context, const unsigned char* data, size_t size)
+{
+    context.length += size;
+
+    if (context.bufferLength + size < 32)
+    {
+        memcpy(context.buffer + context.bufferLength, data, size);
+        context.bufferLength += size;
+        return;
+    }
+
+    if (context.bufferLength > 0)
+    {
+        size_t fill = 32 - context.bufferLength;
+        memcpy(context.buffer + context.bufferLength, data, fill);
+        for (int i = 0; i < 4; ++i)
+        {
+            context.accumulators[i] = XXH64Round(context.accumulators[i], ReadLittleEndian64(context.buffer + i * 8));
+        }
+        data += fill;
+        size -= fill;
+        context.bufferLength = 0;
+    }
+
+    // whole stripes are hashed straight from the caller's buffer
+    while (size >= 32)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            context.accumulators[i] = XXH64Round(context.accumulators[i], ReadLittleEndian64(data + i * 8));
+        }
+        data += 32;
+        size -= 32;
+    }
+
+    if (size > 0)
+    {
+        memcpy(context.buffer, data, size);
+        context.bufferLength = size;
+    }
+}
+
+// function to finish an XXH64 calculation
+uint64_t XXH64Final(const XXH64Context& context)
+{
+    uint64_t hash;
+    if (context.length >= 32)
+    {
+        hash = RotateLeft64(context.accumulators[0], 1) + RotateLeft64(context.accumulators[1], 7) + RotateLeft64(context.accumulators[2], 12) + RotateLeft64(context.accumulators[3], 18);
+        for (int i = 0; i < 4; ++i)
+        {
+            hash = XXH64MergeRound(hash, context.accumulators[i]);
+        }
+    }
+    else
+    {
+        hash = context.seed + XXH64_PRIME5;
+    }
+
+    hash += context.length;
+
+    const unsigned char* data = context.buffer;
+    size_t remaining = context.bufferLength;
+    while (remaining >= 8)
+    {
+        hash ^= XXH64Round(0, ReadLittleEndian64(data));
+        hash = RotateLeft64(hash, 27) * XXH64_PRIME1 + XXH64_PRIME4;
+        data += 8;
+        remaining -= 8;
+    }
+    if (remaining >= 4)
+    {
+        hash ^= static_cast<uint64_t>(ReadLittleEndian32(data)) * XXH64_PRIME1;
+        hash = RotateLeft64(hash, 23) * XXH64_PRIME2 + XXH64_PRIME3;
+        data += 4;
+        remaining -= 4;
+    }
+    while (remaining > 0)
+    {
+        hash ^= static_cast<uint64_t>(*data) * XXH64_PRIME5;
+        hash = RotateLeft64(hash, 11) * XXH64_PRIME1;
+        ++data;
+        --remaining;
+    }
+
+    // final avalanche
+    hash ^= hash >> 33;
+    hash *= XXH64_PRIME2;
+    hash ^= hash >> 29;
+    hash *= XXH64_PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// structure to hold the lookup tables of a slicing-by-8 CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320)
+struct CRC32Tables
+{
+    uint32_t table[8][256];
+
+    CRC32Tables()
+    {
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            for (int slice = 1; slice < 8; ++slice)
+            {
+                table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+// function to get the CRC-32 lookup tables, built once on first use
+const CRC32Tables& GetCRC32Tables()
+{
+    static const CRC32Tables tables;
+    return tables;
+}
+
+// function to add data to a CRC-32, starting from a crc of zero, eight bytes at a time
+uint32_t UpdateCRC32(uint32_t crc, const void* data, size_t size)
+{
+    const uint32_t (*table)[256] = GetCRC32Tables().table;
+    const unsigned char* current = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+
+    while (size >= 8)
+    {
+        uint32_t low = crc ^ ReadLittleEndian32(current);
+        uint32_t high = ReadLittleEndian32(current + 4);
+        crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+            table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+        current += 8;
+        size -= 8;
+    }
+    while (size > 0)
+    {
+        crc = (crc >> 8) ^ table[0][(crc ^ *current) & 0xFF];
+        ++current;
+        --size;
+    }
+    return ~crc;
+}
+
+// function to multiply a vector by a 32x32 matrix over GF(2)
+uint32_t MultiplyGF2Matrix(const uint32_t* matrix, uint32_t vector)
+{
+    uint32_t sum = 0;
+    for (int i = 0; vector != 0; ++i, vector >>= 1)
+    {
+        if (vector & 1)
+        {
+            sum ^= matrix[i];
+        }
+    }
+    return sum;
+}
+
+// function to square a 32x32 matrix over GF(2)
+void SquareGF2Matrix(uint32_t* square, const uint32_t* matrix)
+{
+    for (int i = 0; i < 32; ++i)
+    {
+        square[i] = MultiplyGF2Matrix(matrix, matrix[i]);
+    }
+}
+
+// function to combine the CRC-32 of two consecutive blocks into the CRC-32 of both, so blocks can be hashed independently
+uint32_t CombineCRC32(uint32_t firstCrc, uint32_t secondCrc, unsigned long long secondLength)
+{
+    if (secondLength == 0)
+    {
+        return firstCrc;
+    }
+
+    // operator for one zero bit, then squared into the operators for two and four zero bits
+    uint32_t even[32];
+    uint32_t odd[32];
+    odd[0] = 0xEDB88320;
+    uint32_t row = 1;
+    for (int i = 1; i < 32; ++i)
+    {
+        odd[i] = row;
+        row <<= 1;
+    }
+    SquareGF2Matrix(even, odd);
+    SquareGF2Matrix(odd, even);
+
+    // apply secondLength zero bytes to the first crc, one squaring per bit of the length
+    do
+    {
+        SquareGF2Matrix(even, odd);
+        if (secondLength & 1)
+        {
+            firstCrc = MultiplyGF2Matrix(even, firstCrc);
+        }
+        secondLength >>= 1;
+        if (secondLength == 0)
+        {
+            break;
+        }
+
+        SquareGF2Matrix(odd, even);
+        if (secondLength & 1)
+        {
+            firstCrc = MultiplyGF2Matrix(odd, firstCrc);
+        }
+        secondLength >>= 1;
+    }
+    while (secondLength != 0);
+
+    return firstCrc ^ secondCrc;
+}
+
+
+
+//
+//
+//
+// STREAMING HASHER
+//
+//
+//
+
+
+
+// structure to hold a streaming hash calculation for any supported algorithm
+struct StreamingHasher
+{
+    HashAlgorithm algorithm = HashAlgorithm::MD5;
+    MD5Context md5;
+    XXH64Context xxh64;
+};
+
+// function to start a streaming hash calculation
+void HasherInit(StreamingHasher& hasher, HashAlgorithm algorithm)
+{
+    hasher.algorithm = algorithm;
+    switch (algorithm)
+    {
+    case HashAlgorithm::MD5:
+        MD5Init(hasher.md5);
+        break;
+    case HashAlgorithm::XXH64:
+        XXH64Init(hasher.xxh64);
+        break;
+    }
+}
+
+// function to add data to a streaming hash calculation
+void HasherUpdate(StreamingHasher& hasher, const unsigned char* data, size_t size)
+{
+    switch (hasher.algorithm)
+    {
+    case HashAlgorithm::MD5:
+        MD5Update(hasher.md5, data, size);
+        break;
+    case HashAlgorithm::XXH64:
+        XXH64Update(hasher.xxh64, data, size);
+        break;
+    }
+}
+
+// function to finish a streaming hash calculation as a lower case hexadecimal string
+std::string HasherFinalHex(StreamingHasher& hasher)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    unsigned char digest[16];
+    size_t digestLength = 0;
+
+    switch (hasher.algorithm)
+    {
+    case HashAlgorithm::MD5:
+        MD5Final(hasher.md5, digest);
+        digestLength = 16;
+        break;
+    case HashAlgorithm::XXH64:
+    {
+        // canonical XXH64 representation is big endian
+        uint64_t hash = XXH64Final(hasher.xxh64);
+        for (int i = 0; i < 8; ++i)
+        {
+            digest[i] = static_cast<unsigned char>(hash >> (56 - 8 * i));
+        }
+        digestLength = 8;
+    }
+    break;
+    }
+
+    std::string hexString(digestLength * 2, '0');
+    for (size_t i = 0; i < digestLength; ++i)
+    {
+        hexString[i * 2] = hexDigits[digest[i] >> 4];
+        hexString[i * 2 + 1] = hexDigits[digest[i] & 0x0F];
+    }
+    return hexString;
+}
+
+// function to calculate the hash of a block of memory as a lower case hexadecimal string
+std::string CalculateBufferHash(const void* data, size_t size, HashAlgorithm algorithm)
+{
+    StreamingHasher hasher;
+    HasherInit(hasher, algorithm);
+    HasherUpdate(hasher, static_cast<const unsigned char*>(data), size);
+    return HasherFinalHex(hasher);
+}
+
+// function to calculate the hash of a file, streaming it through a large aligned buffer
+bool CalculateFileHash(const wchar_t* filepath, HashAlgorithm algorithm, std::string& digestString)
+{
+    TRACE_SCOPE("CalculateFileHash", filepath);
+    PortableFile file;
+    if (!OpenPortableFile(filepath, file))
+    {
+        return false;
+    }
+
+    AlignedReadBuffer buffer;
+    AllocateReadBuffer(buffer, HASH_READ_BUFFER_SIZE);
+
+    StreamingHasher hasher;
+    HasherInit(hasher, algorithm);
+
+    size_t bytesRead = 0;
+    while (true)
+    {
+        if (!ReadPortableFile(file, buffer.data, buffer.size, bytesRead))
+        {
+            ClosePortableFile(file);
+            return false;
+        }
+        if (bytesRead == 0)
+        {
+            break;
+        }
+        HasherUpdate(hasher, buffer.data, bytesRead);
+    }
+
+    ClosePortableFile(file);
+    digestString = HasherFinalHex(hasher);
+    return true;
+}
+
+
+// function to copy a file while calculating its hash in the same pass, the copy is flushed to the disk before returning
+bool CopyFileHashed(const wchar_t* sourcePath, const wchar_t* targetPath, HashAlgorithm algorithm, std::string& digestString, unsigned long long& bytesCopied)
+{
+    PortableFile source;
+    if (!OpenPortableFile(sourcePath, source))
+    {
+        return false;
+    }
+
+    PortableFile target;
+    if (!CreatePortableFile(targetPath, target))
+    {
+        ClosePortableFile(source);
+        return false;
+    }
+
+    AlignedReadBuffer buffer;
+    AllocateReadBuffer(buffer, HASH_READ_BUFFER_SIZE);
+
+    StreamingHasher hasher;
+    HasherInit(hasher, algorithm);
+
+    bool success = true;
+    size_t bytesRead = 0;
+    bytesCopied = 0;
+    while (true)
+    {
+        if (!ReadPortableFile(source, buffer.data, buffer.size, bytesRead))
+        {
+            success = false;
+            break;
+        }
+        if (bytesRead == 0)
+        {
+            break;
+        }
+        HasherUpdate(hasher, buffer.data, bytesRead);
+        if (!WritePortableFile(target, buffer.data, bytesRead))
+        {
+            success = false;
+            break;
+        }
+        bytesCopied += bytesRead;
+    }
+
+    success = success && FlushPortableFile(target);
+    ClosePortableFile(source);
+    ClosePortableFile(target);
+
+    if (success)
+    {
+        digestString = HasherFinalHex(hasher);
+    }
+    return success;
+}
@@ -2,6 +2,7 @@
 
 //local headers
 #include "framework.h"
+#include "selftest.h"
 
 // structure to hold the launch configuration
 struct LaunchConfig
@@ -27,12 +28,14 @@ struct LaunchConfig
     std::vector<std::wstring> AdditionalFiles;
     std::wstring BinFolder;
     std::set<std::wstring> IgnoredWarnings;
+    SgaVerificationLevel ArchiveVerification = SgaVerificationLevel::Header; // optional, older configuration files do not have it
+    int ShutdownTimeout = 30; // optional, seconds the launcher waits at most for the game to become ready before closing
 };
 
 // function to validate the presence of necessary injector files
 bool InjectedFilesPresent(const std::wstring& folderPath, const std::vector<std::wstring>& injectedFiles)
 {
-    if (GetFileAttributes(folderPath.c_str()) == INVALID_FILE_ATTRIBUTES)
+    if (!PathExists(folderPath))
     {
         MessageBox(NULL, (L"Failed to find the Injector mod folder. Try again, or reacquire it from the mod package: " + folderPath).c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
         return false;
@@ -42,7 +45,7 @@ bool InjectedFilesPresent(const std::wstring& folderPath, const std::vector<std:
     {
         std::wstring filePath = folderPath + L"\\" + fileName;
 
-        if (GetFileAttributes(filePath.c_str()) == INVALID_FILE_ATTRIBUTES)
+        if (!PathExists(filePath))
         {
             MessageBox(NULL, (L"Failed to find a specific injected file required by this mod. Try again, or reacquire it from the mod package: " + fileName).c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
             return false;
@@ -58,7 +61,7 @@ bool InjectedConfigurationsPresent(const std::wstring& launcherName, const std::
     {
         std::wstring filePath = launcherName + ext;
 
-        if (GetFileAttributes(filePath.c_str()) == INVALID_FILE_ATTRIBUTES)
+        if (!PathExists(filePath))
         {
             MessageBox(NULL, (L"Failed to find a specific injection configuration file required by this mod. Try again, or reacquire it from the mod package: " + filePath).c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
             return false;
@@ -67,778 +70,1364 @@ bool InjectedConfigurationsPresent(const std::wstring& launcherName, const std::
     return true;
 }
 
-// function to read the launch configuration
-LaunchConfig ReadLaunchConfig()
+// types of the values stored in the launch configuration file
+enum class LaunchConfigFieldType
 {
-    wchar_t launcherPath[MAX_PATH];
-    GetModuleFileName(NULL, launcherPath, MAX_PATH);
+    Boolean, // true or false
+    Text, // stored as written
+    List, // entries separated by a comma and a space
+    WarningSet, // warning keys separated by commas
+    VerificationLevel, // none, header or full
+    Integer // whole number
+};
 
-    std::wstring configFilePath = launcherPath;
-    size_t lastDotPos = configFilePath.find_last_of(L".");
-    if (lastDotPos != std::wstring::npos)
+// structure to describe one key of the launch configuration file, the same table drives reading and writing it
+struct LaunchConfigField
+{
+    const wchar_t* key = nullptr;
+    LaunchConfigFieldType type = LaunchConfigFieldType::Text;
+    bool required = true;
+    bool injectorOnly = false; // only validated when the [Injector] field, which has to come first, is true
+    const wchar_t* (*validate)(boost::wstring_view value) = nullptr; // returns the error message for an invalid value or list entry, nullptr when valid
+    bool LaunchConfig::* booleanMember = nullptr;
+    std::wstring LaunchConfig::* textMember = nullptr;
+    std::vector<std::wstring> LaunchConfig::* listMember = nullptr;
+    std::set<std::wstring> LaunchConfig::* setMember = nullptr;
+    SgaVerificationLevel LaunchConfig::* levelMember = nullptr;
+    int LaunchConfig::* integerMember = nullptr;
+};
+
+// function to describe a true or false field
+LaunchConfigField BooleanField(const wchar_t* key, bool LaunchConfig::* member)
+{
+    LaunchConfigField field;
+    field.key = key;
+    field.type = LaunchConfigFieldType::Boolean;
+    field.booleanMember = member;
+    return field;
+}
+
+// function to describe a text field
+LaunchConfigField TextField(const wchar_t* key, std::wstring LaunchConfig::* member, const wchar_t* (*validate)(boost::wstring_view) = nullptr, bool injectorOnly = false)
+{
+    LaunchConfigField field;
+    field.key = key;
+    field.type = LaunchConfigFieldType::Text;
+    field.validate = validate;
+    field.injectorOnly = injectorOnly;
+    field.textMember = member;
+    return field;
+}
+
+// function to describe a field holding a list of entries
+LaunchConfigField ListField(const wchar_t* key, std::vector<std::wstring> LaunchConfig::* member, const wchar_t* (*validate)(boost::wstring_view), bool injectorOnly = false)
+{
+    LaunchConfigField field;
+    field.key = key;
+    field.type = LaunchConfigFieldType::List;
+    field.validate = validate;
+    field.injectorOnly = injectorOnly;
+    field.listMember = member;
+    return field;
+}
+
+// function to describe a field holding a set of warning keys
+LaunchConfigField WarningSetField(const wchar_t* key, std::set<std::wstring> LaunchConfig::* member)
+{
+    LaunchConfigField field;
+    field.key = key;
+    field.type = LaunchConfigFieldType::WarningSet;
+    field.setMember = member;
+    return field;
+}
+
+// function to describe an optional archive verification level field
+LaunchConfigField VerificationLevelField(const wchar_t* key, SgaVerificationLevel LaunchConfig::* member, const wchar_t* (*validate)(boost::wstring_view))
+{
+    LaunchConfigField field;
+    field.key = key;
+    field.type = LaunchConfigFieldType::VerificationLevel;
+    field.required = false;
+    field.validate = validate;
+    field.levelMember = member;
+    return field;
+}
+
+// function to describe an optional whole number field
+LaunchConfigField IntegerField(const wchar_t* key, int LaunchConfig::* member, const wchar_t* (*validate)(boost::wstring_view))
+{
+    LaunchConfigField field;
+    field.key = key;
+    field.type = LaunchConfigFieldType::Integer;
+    field.required = false;
+    field.validate = validate;
+    field.integerMember = member;
+    return field;
+}
+
+// function to validate the [InjectorFileName] field
+const wchar_t* ValidateInjectorFileNameField(boost::wstring_view value)
+{
+    if (!ValidateFileName(value))
     {
-        configFilePath.replace(lastDotPos, std::wstring::npos, L".launchconfig");
+        return L"Invalid formatting for the [InjectorFileName] field of the launch configuration file. The full file name must include the file extension.";
     }
+    return nullptr;
+}
 
-    std::wifstream configFile(configFilePath);
-    if (!configFile.is_open())
+// function to validate the [LaunchParams] field
+const wchar_t* ValidateLaunchParamsField(boost::wstring_view value)
+{
+    if (!ValidateLaunchParams(value))
     {
-        MessageBox(NULL, L"Failed to find or open the launch configuration file. Reacquire it from the mod package, or try again.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-        exit(1);
+        return L"Invalid formatting for the [LaunchParams] field of the launch configuration file. Each parameter must start with a [-] sign, and be separated by a space.";
+    }
+    if (value.find(L"-modname") != boost::wstring_view::npos)
+    {
+        return L"The [LaunchParams] field of the launch configuration file contains the -modname parameter, which is automatically applied with the appropriate argument for this mod based on the name of the launcher. Remove -modname from the launch configuration file.";
     }
+    return nullptr;
+}
 
-    LaunchConfig config;
-    std::wstring line;
-    std::set<std::wstring> requiredKeys = 
+// function to validate an entry of the [InjectedFiles] field
+const wchar_t* ValidateInjectedFileEntry(boost::wstring_view entry)
+{
+    if (entry.find(L".dll") == boost::wstring_view::npos)
     {
-        L"Injector", L"InjectorFileName", L"LaunchParams", L"IsRetribution", L"IsSteam", L"VerboseDebug", L"IsDXVK", L"FirstTimeLaunchCheck", L"FirstTimeLaunchMessage", L"IsUnsafe", L"Console", L"InjectedFiles", L"InjectedConfigurations", L"GameVersion", L"LAAPatch", L"UIWarnings", L"WIN7CompatibilityMode", L"Warnings", L"AdditionalFiles", L"BinFolder", L"IgnoredWarnings"
-    };
-    std::map<std::wstring, int> lineNumbers;
-    int lineNumber = 0;
+        return L"Invalid formatting for the [InjectedFiles] field of the launch configuration file. Each full file name must include the DLL file extension.";
+    }
+    return nullptr;
+}
 
-    while (std::getline(configFile, line))
+// function to validate an entry of the [InjectedConfigurations] field
+const wchar_t* ValidateInjectedConfigurationEntry(boost::wstring_view entry)
+{
+    if (entry.find(L'.') == boost::wstring_view::npos)
     {
-        lineNumber++;
-        size_t pos = line.find(L"=");
-        if (pos == std::wstring::npos) continue;
+        return L"Invalid formatting for the [InjectedConfigurations] field of the launch configuration file. Each entry must be a valid file extension for injection configuration file types used by this mod.";
+    }
+    return nullptr;
+}
 
-        std::wstring key = line.substr(0, pos);
-        std::wstring value = line.substr(pos + 1);
+// function to validate an entry of the [AdditionalFiles] field
+const wchar_t* ValidateAdditionalFileEntry(boost::wstring_view entry)
+{
+    if (entry.find(L'.') == boost::wstring_view::npos)
+    {
+        return L"Invalid formatting for the [AdditionalFiles] field of the launch configuration file. Each full file name must include a file extension.";
+    }
+    return nullptr;
+}
+
+// function to validate the [ArchiveVerification] field
+const wchar_t* ValidateArchiveVerificationField(boost::wstring_view value)
+{
+    SgaVerificationLevel level;
+    if (!ParseSgaVerificationLevel(std::wstring(value.data(), value.size()), level))
+    {
+        return L"Invalid formatting for the [ArchiveVerification] field of the launch configuration file. It must be none, header or full.";
+    }
+    return nullptr;
+}
+
+// function to validate the [ShutdownTimeout] field
+const wchar_t* ValidateShutdownTimeoutField(boost::wstring_view value)
+{
+    if (!ValidateIntegerField(value) || value[0] == L'-' || value.size() > 3 || std::stoi(std::wstring(value.data(), value.size())) > 600)
+    {
+        return L"Invalid formatting for the [ShutdownTimeout] field of the launch configuration file. It must be a number of seconds between 0 and 600.";
+    }
+    return nullptr;
+}
+
+// function to get the launch configuration schema, in the order the fields are written
+const std::vector<LaunchConfigField>& GetLaunchConfigSchema()
+{
+    static const std::vector<LaunchConfigField> schema =
+    {
+        BooleanField(L"IsRetribution", &LaunchConfig::IsRetribution),
+        BooleanField(L"IsSteam", &LaunchConfig::IsSteam),
+        TextField(L"GameVersion", &LaunchConfig::GameVersion),
+        TextField(L"BinFolder", &LaunchConfig::BinFolder),
+        BooleanField(L"IsDXVK", &LaunchConfig::IsDXVK),
+        BooleanField(L"LAAPatch", &LaunchConfig::LAAPatch),
+        BooleanField(L"UIWarnings", &LaunchConfig::UIWarnings),
+        BooleanField(L"WIN7CompatibilityMode", &LaunchConfig::WIN7CompatibilityMode),
+        TextField(L"LaunchParams", &LaunchConfig::LaunchParams, ValidateLaunchParamsField),
+        BooleanField(L"Injector", &LaunchConfig::Injector),
+        TextField(L"InjectorFileName", &LaunchConfig::InjectorFileName, ValidateInjectorFileNameField, true),
+        ListField(L"InjectedFiles", &LaunchConfig::InjectedFiles, ValidateInjectedFileEntry, true),
+        ListField(L"InjectedConfigurations", &LaunchConfig::InjectedConfigurations, ValidateInjectedConfigurationEntry, true),
+        ListField(L"AdditionalFiles", &LaunchConfig::AdditionalFiles, ValidateAdditionalFileEntry),
+        BooleanField(L"FirstTimeLaunchCheck", &LaunchConfig::FirstTimeLaunchCheck),
+        TextField(L"FirstTimeLaunchMessage", &LaunchConfig::FirstTimeLaunchMessage),
+        BooleanField(L"VerboseDebug", &LaunchConfig::VerboseDebug),
+        BooleanField(L"Warnings", &LaunchConfig::Warnings),
+        WarningSetField(L"IgnoredWarnings", &LaunchConfig::IgnoredWarnings),
+        BooleanField(L"IsUnsafe", &LaunchConfig::IsUnsafe),
+        BooleanField(L"Console", &LaunchConfig::Console),
+        VerificationLevelField(L"ArchiveVerification", &LaunchConfig::ArchiveVerification, ValidateArchiveVerificationField),
+        IntegerField(L"ShutdownTimeout", &LaunchConfig::ShutdownTimeout, ValidateShutdownTimeoutField)
+    };
+    return schema;
+}
+
+// function to get the path of the launch configuration file next to the launcher
+std::wstring GetLaunchConfigFilePath()
+{
+    wchar_t launcherPath[MAX_PATH];
+    GetModuleFileName(NULL, launcherPath, MAX_PATH);
+
+    std::wstring configFilePath = launcherPath;
+    size_t lastDotPos = configFilePath.find_last_of(L".");
+    if (lastDotPos != std::wstring::npos)
+    {
+        configFilePath.replace(lastDotPos, std::wstring::npos, L".launchconfig");
+    }
+    return configFilePath;
+}
 
-        lineNumbers[key] = lineNumber;
+// function to parse the value of one launch configuration field into the configuration, reporting the field's error message if it is invalid
+bool ReadLaunchConfigField(const LaunchConfigField& field, boost::wstring_view value, LaunchConfig& config)
+{
+    switch (field.type)
+    {
+    case LaunchConfigFieldType::Boolean:
+        if (!ValidateBooleanField(value))
+        {
+            ReportError(L"Invalid formatting for the [" + std::wstring(field.key) + L"] field of the launch configuration file. It must be true or false.");
+            return false;
+        }
+        config.*field.booleanMember = (value == L"true");
+        break;
 
-        if (key == L"Injector")
+    case LaunchConfigFieldType::Text:
+        if (field.injectorOnly && !config.Injector)
         {
-            if (!ValidateBooleanField(value))
-            {
-                MessageBox(NULL, L"Invalid formatting for the [Injector] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
-            }
-            config.Injector = (value == L"true");
+            break;
         }
-        else if (key == L"InjectorFileName")
+        if (field.validate != nullptr)
         {
-            if (config.Injector)
+            const wchar_t* error = field.validate(value);
+            if (error != nullptr)
             {
-                config.InjectorFileName = value;
-                if (!ValidateFileName(config.InjectorFileName))
-                {
-                    MessageBox(NULL, L"Invalid formatting for the [InjectorFileName] field of the launch configuration file. The full file name must include the file extension.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                    exit(1);
-                }
+                ReportError(error);
+                return false;
             }
         }
-        else if (key == L"LaunchParams")
+        (config.*field.textMember).assign(value.data(), value.size());
+        break;
+
+    case LaunchConfigFieldType::List:
+        // an unvalidated list is kept as written, so it is written back unchanged
+        if (field.injectorOnly && !config.Injector)
         {
-            config.LaunchParams = value;
-            if (!ValidateLaunchParams(config.LaunchParams))
+            (config.*field.listMember).emplace_back(value.data(), value.size());
+            break;
+        }
+        if (value.empty())
+        {
+            break;
+        }
+        for (;;)
+        {
+            size_t separatorPos = value.find(L", ");
+            boost::wstring_view entry = TrimWStringView(value.substr(0, separatorPos));
+            const wchar_t* error = field.validate(entry);
+            if (error != nullptr)
             {
-                MessageBox(NULL, L"Invalid formatting for the [LaunchParams] field of the launch configuration file. Each parameter must start with a [-] sign, and be separated by a space.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
+                ReportError(error);
+                return false;
             }
-            if (config.LaunchParams.find(L"-modname") != std::wstring::npos)
+            (config.*field.listMember).emplace_back(entry.data(), entry.size());
+            if (separatorPos == boost::wstring_view::npos)
             {
-                MessageBox(NULL, L"The [LaunchParams] field of the launch configuration file contains the -modname parameter, which is automatically applied with the appropriate argument for this mod based on the name of the launcher. Remove -modname from the launch configuration file.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
+                break;
             }
+            value = value.substr(separatorPos + 2);
         }
-        else if (key == L"IsRetribution")
+        break;
+
+    case LaunchConfigFieldType::WarningSet:
+        while (!value.empty())
         {
-            if (!ValidateBooleanField(value))
-            {
-                MessageBox(NULL, L"Invalid formatting for the [IsRetribution] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
-            }
-            config.IsRetribution = (value == L"true");
+            size_t separatorPos = value.find(L',');
+            boost::wstring_view entry = TrimWStringView(value.substr(0, separatorPos));
+            (config.*field.setMember).emplace(entry.data(), entry.size());
+            value = (separatorPos == boost::wstring_view::npos) ? boost::wstring_view() : value.substr(separatorPos + 1);
         }
-        else if (key == L"IsSteam")
+        break;
+
+    case LaunchConfigFieldType::VerificationLevel:
         {
-            if (!ValidateBooleanField(value))
+            const wchar_t* error = field.validate(value);
+            if (error != nullptr)
             {
-                MessageBox(NULL, L"Invalid formatting for the [IsSteam] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
+                ReportError(error);
+                return false;
             }
-            config.IsSteam = (value == L"true");
+            ParseSgaVerificationLevel(std::wstring(value.data(), value.size()), config.*field.levelMember);
         }
-        else if (key == L"VerboseDebug")
+        break;
+
+    case LaunchConfigFieldType::Integer:
         {
-            if (!ValidateBooleanField(value))
+            const wchar_t* error = field.validate(value);
+            if (error != nullptr)
             {
-                MessageBox(NULL, L"Invalid formatting for the [VerboseDebug] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
+                ReportError(error);
+                return false;
             }
-            config.VerboseDebug = (value == L"true");
+            config.*field.integerMember = std::stoi(std::wstring(value.data(), value.size()));
         }
-        else if (key == L"IsDXVK")
+        break;
+    }
+    return true;
+}
+
+// function to format the value of one launch configuration field as it is written in the file
+std::wstring FormatLaunchConfigValue(const LaunchConfigField& field, const LaunchConfig& config)
+{
+    std::wstring value;
+    switch (field.type)
+    {
+    case LaunchConfigFieldType::Boolean:
+        value = config.*field.booleanMember ? L"true" : L"false";
+        break;
+
+    case LaunchConfigFieldType::Text:
+        value = config.*field.textMember;
+        break;
+
+    case LaunchConfigFieldType::List:
+        for (size_t i = 0; i < (config.*field.listMember).size(); ++i)
         {
-            if (!ValidateBooleanField(value))
+            if (i > 0)
             {
-                MessageBox(NULL, L"Invalid formatting for the [IsDXVK] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
+                value += L", ";
             }
-            config.IsDXVK = (value == L"true");
+            value += (config.*field.listMember)[i];
         }
-        else if (key == L"FirstTimeLaunchCheck")
+        break;
+
+    case LaunchConfigFieldType::WarningSet:
+        for (auto it = (config.*field.setMember).begin(); it != (config.*field.setMember).end(); ++it)
         {
-            if (!ValidateBooleanField(value))
+            if (it != (config.*field.setMember).begin())
             {
-                MessageBox(NULL, L"Invalid formatting for the [FirstTimeLaunchCheck] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
+                value += L", ";
             }
-            config.FirstTimeLaunchCheck = (value == L"true");
+            value += *it;
+        }
+        break;
+
+    case LaunchConfigFieldType::VerificationLevel:
+        value = GetSgaVerificationLevelName(config.*field.levelMember);
+        break;
+
+    case LaunchConfigFieldType::Integer:
+        value = std::to_wstring(config.*field.integerMember);
+        break;
+    }
+    return value;
+}
+
+// function to check whether a launch configuration line is a comment, which starts with ; or #
+bool IsLaunchConfigComment(boost::wstring_view line)
+{
+    return !line.empty() && (line[0] == L';' || line[0] == L'#');
+}
+
+// function to read the launch configuration from a .launchconfig file, reporting the first error found in it
+bool ReadLaunchConfig(const std::wstring& configFilePath, LaunchConfig& config)
+{
+    TRACE_SCOPE("ReadLaunchConfig");
+    std::wifstream configFile(configFilePath);
+    if (!configFile.is_open())
+    {
+        ReportError(L"Failed to find or open the launch configuration file. Reacquire it from the mod package, or try again.");
+        return false;
+    }
+
+    // the file is read in one piece, lines, keys and values are views into it
+    std::wstring content((std::istreambuf_iterator<wchar_t>(configFile)), std::istreambuf_iterator<wchar_t>());
+    configFile.close();
+
+    const std::vector<LaunchConfigField>& schema = GetLaunchConfigSchema();
+    std::vector<bool> fieldsRead(schema.size(), false);
+    config = LaunchConfig();
+    int lineNumber = 0;
+
+    boost::wstring_view remaining(content);
+    while (!remaining.empty())
+    {
+        size_t lineEnd = remaining.find(L'\n');
+        boost::wstring_view line = remaining.substr(0, lineEnd);
+        remaining = (lineEnd == boost::wstring_view::npos) ? boost::wstring_view() : remaining.substr(lineEnd + 1);
+        lineNumber++;
+
+        // comment lines are skipped whatever they hold, every other line with a key outside the schema is still rejected
+        if (IsLaunchConfigComment(line)) continue;
+
+        size_t pos = line.find(L'=');
+        if (pos == boost::wstring_view::npos) continue;
+
+        boost::wstring_view key = line.substr(0, pos);
+        boost::wstring_view value = line.substr(pos + 1);
+
+        size_t fieldIndex = 0;
+        while (fieldIndex < schema.size() && key != schema[fieldIndex].key)
+        {
+            fieldIndex++;
         }
-        else if (key == L"IsUnsafe")
+        if (fieldIndex == schema.size())
         {
-            if (!ValidateBooleanField(value))
-            {
-                MessageBox(NULL, L"Invalid formatting for the [IsUnsafe] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
-            }
-            config.IsUnsafe = (value == L"true");
+            ReportError(L"Unexpected configuration key: " + std::wstring(key.data(), key.size()) + L" on line " + std::to_wstring(lineNumber) + L". Reacquire the launch configuration file from the mod package, or try again.");
+            return false;
         }
-        else if (key == L"Console")
+
+        if (!ReadLaunchConfigField(schema[fieldIndex], value, config))
         {
-            if (!ValidateBooleanField(value))
-            {
-                MessageBox(NULL, L"Invalid formatting for the [Console] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
-            }
-            config.Console = (value == L"true");
+            return false;
         }
-        else if (key == L"InjectedFiles")
+        fieldsRead[fieldIndex] = true;
+    }
+
+    // the missing keys are listed in alphabetical order
+    std::set<std::wstring> missingKeys;
+    for (size_t i = 0; i < schema.size(); ++i)
+    {
+        if (schema[i].required && !fieldsRead[i])
         {
-            if (config.Injector)
-            {
-                if (!value.empty())
-                {
-                    std::wistringstream ss(value);
-                    std::wstring token;
-                    size_t startPos = 0, endPos;
-                    while ((endPos = value.find(L", ", startPos)) != std::wstring::npos)
-                    {
-                        token = value.substr(startPos, endPos - startPos);
-                        token = TrimWString(token);
-                        if (token.find(L".dll") == std::wstring::npos)
-                        {
-                            MessageBox(NULL, L"Invalid formatting for the [InjectedFiles] field of the launch configuration file. Each full file name must include the DLL file extension.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                            exit(1);
-                        }
-                        if (value[endPos + 1] != L' ')
-                        {
-                            MessageBox(NULL, L"Invalid formatting for the [InjectedFiles] field of the launch configuration file. Each entry must be separated by a comma and a space.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                            exit(1);
-                        }
-                        config.InjectedFiles.push_back(token);
-                        startPos = endPos + 2;
-                    }
-                    token = value.substr(startPos);
-                    token = TrimWString(token);
-                    if (token.find(L".dll") == std::wstring::npos)
-                    {
-                        MessageBox(NULL, L"Invalid formatting for the [InjectedFiles] field of the launch configuration file. Each full file name must include the DLL file extension.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                        exit(1);
-                    }
-                    config.InjectedFiles.push_back(token);
-                }
-            }
-            else
-            {
-                config.InjectedFiles.push_back(value);
-            }
+            missingKeys.insert(schema[i].key);
         }
-        else if (key == L"InjectedConfigurations")
+    }
+
+    if (!missingKeys.empty())
+    {
+        std::wstring errorMsg = L"Missing or misspelled configuration keys: ";
+        for (const auto& key : missingKeys)
         {
-            if (config.Injector)
+            errorMsg += key + L", ";
+        }
+
+        // remove the last comma and space
+        errorMsg = errorMsg.substr(0, errorMsg.length() - 2);
+        ReportError(errorMsg);
+        return false;
+    }
+
+    return true;
+}
+
+// structure to hold the launch configuration fields changed since the file was read, written back together by FlushLaunchConfig
+struct LaunchConfigChanges
+{
+    std::set<std::wstring> dirtyKeys;
+    std::mutex mutex;
+};
+
+// global set of changed launch configuration fields
+LaunchConfigChanges launchConfigChanges;
+
+// function to mark a launch configuration field as changed, it is written by the next FlushLaunchConfig
+void MarkLaunchConfigDirty(const std::wstring& key)
+{
+    std::lock_guard<std::mutex> lock(launchConfigChanges.mutex);
+    launchConfigChanges.dirtyKeys.insert(key);
+}
+
+// function to convert launch configuration text to the bytes stored in the file, the inverse of how the file is read
+std::string NarrowLaunchConfigText(const std::wstring& text)
+{
+    std::string narrowText(text.size(), '?');
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (text[i] <= 0xFF)
+        {
+            narrowText[i] = static_cast<char>(text[i]);
+        }
+    }
+    return narrowText;
+}
+
+// function to write the changed launch configuration fields back to the file in one pass, through a temporary file renamed over it
+// only the lines of changed fields are replaced, comments and every other line are kept byte for byte, and changed fields missing from the file are appended
+bool FlushLaunchConfig(const LaunchConfig& config)
+{
+    TRACE_SCOPE("FlushLaunchConfig");
+    std::lock_guard<std::mutex> lock(launchConfigChanges.mutex);
+    if (launchConfigChanges.dirtyKeys.empty())
+    {
+        return true;
+    }
+
+    std::wstring configFilePath = GetLaunchConfigFilePath();
+    std::string content;
+    if (!ReadWholeFile(configFilePath, content))
+    {
+        MessageBox(NULL, L"Failed to find or open the launch configuration file. Reacquire it from the mod package, or try again.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+        return false;
+    }
+
+    const std::vector<LaunchConfigField>& schema = GetLaunchConfigSchema();
+    std::set<std::wstring> writtenKeys;
+    std::string output;
+    output.reserve(content.size() + 256);
+
+    size_t lineStart = 0;
+    while (lineStart < content.size())
+    {
+        size_t lineEnd = content.find('\n', lineStart);
+        size_t nextLine = (lineEnd == std::string::npos) ? content.size() : lineEnd + 1;
+        size_t bodyEnd = (lineEnd == std::string::npos) ? content.size() : lineEnd;
+        if (bodyEnd > lineStart && content[bodyEnd - 1] == '\r')
+        {
+            bodyEnd--;
+        }
+
+        size_t equalsPos = static_cast<size_t>(std::find(content.begin() + lineStart, content.begin() + bodyEnd, '=') - content.begin());
+        if (equalsPos < bodyEnd && content[lineStart] != ';' && content[lineStart] != '#')
+        {
+            std::wstring key(content.begin() + lineStart, content.begin() + equalsPos);
+            if (launchConfigChanges.dirtyKeys.count(key) != 0)
             {
-                if (!value.empty())
+                for (const auto& field : schema)
                 {
-                    std::wistringstream ss(value);
-                    std::wstring token;
-                    size_t startPos = 0, endPos;
-                    while ((endPos = value.find(L", ", startPos)) != std::wstring::npos)
+                    if (key == field.key)
                     {
-                        token = value.substr(startPos, endPos - startPos);
-                        token = TrimWString(token);
-                        if (token.find(L'.') == std::wstring::npos)
-                        {
-                            MessageBox(NULL, L"Invalid formatting for the [InjectedConfigurations] field of the launch configuration file. Each entry must be a valid file extension for injection configuration file types used by this mod.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                            exit(1);
-                        }
-                        if (value[endPos + 1] != L' ')
-                        {
-                            MessageBox(NULL, L"Invalid formatting for the [InjectedConfigurations] field of the launch configuration file. Each entry must be separated by a comma and a space.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                            exit(1);
-                        }
-                        config.InjectedConfigurations.push_back(token);
-                        startPos = endPos + 2;
-                    }
-                    token = value.substr(startPos);
-                    token = TrimWString(token);
-                    if (token.find(L'.') == std::wstring::npos)
-                    {
-                        MessageBox(NULL, L"Invalid formatting for the [InjectedConfigurations] field of the launch configuration file. Each entry must be a valid file extension for injection configuration file types used by this mod.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                        exit(1);
+                        output.append(content, lineStart, equalsPos + 1 - lineStart);
+                        output += NarrowLaunchConfigText(FormatLaunchConfigValue(field, config));
+                        output.append(content, bodyEnd, nextLine - bodyEnd);
+                        writtenKeys.insert(key);
+                        break;
                     }
-                    config.InjectedConfigurations.push_back(token);
                 }
+                lineStart = nextLine;
+                continue;
             }
-            else
+        }
+
+        output.append(content, lineStart, nextLine - lineStart);
+        lineStart = nextLine;
+    }
+
+    // fields the file did not have yet are appended with the line break style it already uses
+    const char* lineBreak = (content.find("\r\n") != std::string::npos) ? "\r\n" : "\n";
+    for (const auto& field : schema)
+    {
+        if (launchConfigChanges.dirtyKeys.count(field.key) != 0 && writtenKeys.count(field.key) == 0)
+        {
+            if (!output.empty() && output.back() != '\n')
             {
-                config.InjectedConfigurations.push_back(value);
+                output += lineBreak;
             }
+            output += NarrowLaunchConfigText(std::wstring(field.key) + L"=" + FormatLaunchConfigValue(field, config));
+            output += lineBreak;
         }
-        else if (key == L"FirstTimeLaunchMessage")
+    }
+
+    if (!WriteWholeFile(configFilePath, nullptr, 0, output.data(), output.size()))
+    {
+        MessageBox(NULL, L"Failed to save changes to the launch configuration file. Check that it is not read-only, or try again.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+        return false;
+    }
+
+    launchConfigChanges.dirtyKeys.clear();
+    return true;
+}
+
+// structure to flush the changed launch configuration fields when it goes out of scope, so an early return still keeps dismissed warnings
+struct LaunchConfigFlushGuard
+{
+    const LaunchConfig& config;
+
+    explicit LaunchConfigFlushGuard(const LaunchConfig& launchConfig) : config(launchConfig)
+    {
+    }
+
+    ~LaunchConfigFlushGuard()
+    {
+        FlushLaunchConfig(config);
+    }
+
+    LaunchConfigFlushGuard(const LaunchConfigFlushGuard&) = delete;
+    LaunchConfigFlushGuard& operator=(const LaunchConfigFlushGuard&) = delete;
+};
+
+// function to read the injector mod folder
+std::wstring ReadModFolderFromConfig(const std::wstring& configFilePath)
+{
+    std::wifstream configFile(configFilePath);
+    if (!configFile.is_open())
+    {
+        MessageBox(NULL, (L"Failed to find or open the mod's " + configFilePath + L" injector config file. Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+        exit(1);
+    }
+
+    std::wstring line;
+    std::wstring modFolder;
+    while (std::getline(configFile, line))
+    {
+        size_t pos = line.find(L":");
+        if (pos == std::wstring::npos) continue;
+
+        std::wstring key = line.substr(0, pos);
+        std::wstring value = line.substr(pos + 1);
+
+        if (key == L"mod-folder")
         {
-            config.FirstTimeLaunchMessage = value;
+            modFolder = TrimWString(value);
+            break;
         }
-        else if (key == L"GameVersion")
+    }
+    configFile.close();
+
+    return modFolder;
+}
+
+// function to build the path of the .bin baseline for a file
+std::wstring GetBinFilePath(const LaunchConfig& config, const std::wstring& launcherName, const std::wstring& baseFileName)
+{
+    return config.BinFolder + L"\\" + launcherName + L"_" + baseFileName + L".bin";
+}
+
+// function to build the path of the .bin baseline for the injector
+std::wstring GetInjectorBinFilePath(const LaunchConfig& config, const std::wstring& launcherName)
+{
+    return GetBinFilePath(config, launcherName, config.InjectorFileName.substr(0, config.InjectorFileName.find_last_of(L".")));
+}
+
+// function to collect every file and .bin baseline pair that the launch checks verify, in the order they are verified
+std::vector<FilePairCheck> CollectBinFileChecks(const LaunchConfig& config, const std::wstring& launcherName, bool verifyXThread)
+{
+    std::vector<FilePairCheck> checks;
+    auto addCheck = [&checks](const std::wstring& filePath, const std::wstring& baselinePath)
         {
-            config.GameVersion = value;
+            FilePairCheck check;
+            check.filePath = filePath;
+            check.baselinePath = baselinePath;
+            checks.push_back(check);
+        };
+
+    if (verifyXThread)
+    {
+        addCheck(L"XThread.dll", GetBinFilePath(config, launcherName, L"XThread"));
+    }
+
+    if (config.IsDXVK && config.Injector)
+    {
+        addCheck(L"DivxDecoder.dll", GetBinFilePath(config, launcherName, L"DivxDecoder"));
+        addCheck(L"DivxMediaLib.dll", GetBinFilePath(config, launcherName, L"DivxMediaLib"));
+    }
+
+    if (config.Injector && !config.InjectorFileName.empty())
+    {
+        addCheck(config.InjectorFileName, GetInjectorBinFilePath(config, launcherName));
+    }
+
+    for (const auto& fileName : config.AdditionalFiles)
+    {
+        size_t lastDotPos = fileName.find_last_of(L'.');
+        std::wstring baseFileName = (lastDotPos == std::wstring::npos) ? fileName : fileName.substr(0, lastDotPos);
+        if (fileName.empty() || baseFileName == launcherName + L"_")
+        {
+            continue;
         }
-        else if (key == L"LAAPatch")
+        addCheck(fileName, GetBinFilePath(config, launcherName, baseFileName));
+    }
+
+    return checks;
+}
+
+// function to take the precomputed check of a file pair, or to compare the pair now if it was not collected up front
+FilePairCheck TakeBinFileCheck(std::vector<FilePairCheck>& checks, const std::wstring& filePath, const std::wstring& baselinePath)
+{
+    for (auto it = checks.begin(); it != checks.end(); ++it)
+    {
+        if (it->filePath == filePath && it->baselinePath == baselinePath)
         {
-            if (!ValidateBooleanField(value))
-            {
-                MessageBox(NULL, L"Invalid formatting for the [LAAPatch] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
-            }
-            config.LAAPatch = (value == L"true");
+            // each precomputed result is used once, later verifications of the same file compare it again
+            FilePairCheck check = *it;
+            checks.erase(it);
+            return check;
         }
-        else if (key == L"UIWarnings")
+    }
+
+    return CheckFilePair(filePath, baselinePath);
+}
+
+// function to discard precomputed checks involving a file that has just been written
+void InvalidateBinFileChecks(std::vector<FilePairCheck>& checks, const std::wstring& filePath)
+{
+    checks.erase(std::remove_if(checks.begin(), checks.end(), [&filePath](const FilePairCheck& check)
         {
-            if (!ValidateBooleanField(value))
-            {
-                MessageBox(NULL, L"Invalid formatting for the [UIWarnings] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
-            }
-            config.UIWarnings = (value == L"true");
+            return check.filePath == filePath || check.baselinePath == filePath;
+        }), checks.end());
+}
+
+// function to handle the binary processing with a timeout
+bool InjectorBinaryProcessing(const LaunchConfig& config, const std::wstring& launcherName, std::vector<FilePairCheck>& binFileChecks)
+{
+    // Construct the injector bin file name using the launcher name and _injectorfilename from the configuration
+    std::wstring binFileName = GetInjectorBinFilePath(config, launcherName);
+    FilePairCheck check = TakeBinFileCheck(binFileChecks, config.InjectorFileName, binFileName);
+
+    // check the expected checksum from the .bin file
+    if (!check.baselineReadable)
+    {
+        std::wstringstream errorMessage;
+        errorMessage << L"Failed to calculate the MD5 checksum of the " << binFileName << L" file in order to validate the injector. The file may be missing. Reacquire it from the mod package, or try again.";
+        MessageBox(NULL, errorMessage.str().c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+        return false;
+    }
+
+    // compare the injector file against the .bin file
+    if (check.fileReadable && !check.filesMatch)
+    {
+        RestoreResult restoreResult = RestoreFileFromBaseline(binFileName, config.InjectorFileName);
+        if (restoreResult == RestoreResult::CopyFailed)
+        {
+            std::wstringstream errorMessage;
+            errorMessage << L"Failed to replace the " << config.InjectorFileName << L" file with the valid injector version for this mod. The file " << binFileName << L" may be missing. Reacquire it from the mod package, or try again.";
+            MessageBox(NULL, errorMessage.str().c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+            return false;
+        }
+
+        // the restored data is verified while it is copied
+        if (restoreResult == RestoreResult::Mismatched)
+        {
+            std::wstringstream errorMessage;
+            errorMessage << config.InjectorFileName << L" file MD5 checksum still mismatched after attempted replacement with the valid injector version for this mod. Reacquire it from the mod package, or try again.";
+            MessageBox(NULL, errorMessage.str().c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+            return false;
         }
-        else if (key == L"WIN7CompatibilityMode")
+    }
+    return true;
+}
+
+// structure to hold one UCS key and the line it is defined on, a sorted vector of these is the key index of a file
+struct UCSKeyEntry
+{
+    uint32_t key;
+    uint32_t line;
+};
+
+// function to order UCS key entries by key, and by line for entries with the same key
+bool operator<(const UCSKeyEntry& left, const UCSKeyEntry& right)
+{
+    return left.key < right.key || (left.key == right.key && left.line < right.line);
+}
+
+// structure to hold the results of processing a single UCS file
+struct UCSFileResult
+{
+    std::vector<UCSKeyEntry> keys;
+    std::vector<std::wstring> errors;
+};
+
+// function to validate the numeric key grammar of UTF-16 LE UCS content, walking the lines in place without copying them and collecting every malformed line
+bool ScanUCSEntries(const char16_t* begin, const char16_t* end, const std::wstring& filePath, std::vector<UCSKeyEntry>& keys, std::vector<std::wstring>& errors)
+{
+    size_t initialErrorCount = errors.size();
+    int lineNumber = 0;
+    const char16_t* lineStart = begin;
+
+    while (lineStart < end)
+    {
+        const char16_t* lineEnd = lineStart;
+        while (lineEnd < end && *lineEnd != u'\n')
         {
-            if (!ValidateBooleanField(value))
-            {
-                MessageBox(NULL, L"Invalid formatting for the [WIN7CompatibilityMode] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
-            }
-            config.WIN7CompatibilityMode = (value == L"true");
+            ++lineEnd;
         }
-        else if (key == L"Warnings")
+        const char16_t* nextLineStart = (lineEnd < end) ? lineEnd + 1 : end;
+        if (lineEnd > lineStart && lineEnd[-1] == u'\r')
         {
-            if (!ValidateBooleanField(value))
-            {
-                MessageBox(NULL, L"Invalid formatting for the [Warnings] field of the launch configuration file. It must be true or false.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                exit(1);
-            }
-            config.Warnings = (value == L"true");
+            --lineEnd;
         }
-        else if (key == L"AdditionalFiles")
+        lineNumber++;
+
+        const char16_t* current = lineStart;
+        lineStart = nextLineStart;
+
+        // allow empty lines
+        if (current == lineEnd)
         {
-            if (!value.empty())
-            {
-                std::wistringstream ss(value);
-                std::wstring token;
-                size_t startPos = 0, endPos;
-                while ((endPos = value.find(L", ", startPos)) != std::wstring::npos)
-                {
-                    token = value.substr(startPos, endPos - startPos);
-                    token = TrimWString(token);
-                    if (token.find(L".") == std::wstring::npos)
-                    {
-                        MessageBox(NULL, L"Invalid formatting for the [AdditionalFiles] field of the launch configuration file. Each full file name must include a file extension.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                        exit(1);
-                    }
-                    if (value[endPos + 1] != L' ')
-                    {
-                        MessageBox(NULL, L"Invalid formatting for the [AdditionalFiles] field of the launch configuration file. Each entry must be separated by a comma and a space.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                        exit(1);
-                    }
-                    config.AdditionalFiles.push_back(token);
-                    startPos = endPos + 2;
-                }
-                token = value.substr(startPos);
-                token = TrimWString(token);
-                if (token.find(L".") == std::wstring::npos)
-                {
-                    MessageBox(NULL, L"Invalid formatting for the [AdditionalFiles] field of the launch configuration file. Each full file name must include a file extension.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                    exit(1);
-                }
-                config.AdditionalFiles.push_back(token);
-            }
-            else
-            {
-                config.AdditionalFiles.push_back(value);
-            }
+            continue;
+        }
+
+        // skip leading whitespace
+        while (current < lineEnd && (*current == u' ' || *current == u'\t'))
+        {
+            ++current;
+        }
+
+        // check if the line is entirely whitespace
+        if (current == lineEnd)
+        {
+            errors.push_back(L"Whitespace entry in UCS file: " + filePath + L"\nLine: " + std::to_wstring(lineNumber));
+            continue;
         }
-        else if (key == L"BinFolder")
+
+        // the entry text is only copied out for an error message
+        const char16_t* entryStart = current;
+
+        // if no digits found at the start of the line
+        if (*current < u'0' || *current > u'9')
         {
-            config.BinFolder = value;
+            errors.push_back(L"Not a numeric entry in UCS file: " + filePath + L"\nLine: " + std::to_wstring(lineNumber) + L": " + std::wstring(entryStart, lineEnd));
+            continue;
         }
-        else if (key == L"IgnoredWarnings")
+
+        // parse the number part, which has to fit the 32-bit keys the game uses
+        unsigned long long currentNumber = 0;
+        bool numberOverflow = false;
+        while (current < lineEnd && *current >= u'0' && *current <= u'9')
         {
-            std::wistringstream ss(value);
-            std::wstring token;
-            while (std::getline(ss, token, L','))
+            currentNumber = currentNumber * 10 + (*current - u'0');
+            if (currentNumber > 0xFFFFFFFFULL)
             {
-                config.IgnoredWarnings.insert(TrimWString(token));
+                numberOverflow = true;
+                break;
             }
+            ++current;
         }
-        else
+
+        if (numberOverflow)
         {
-            MessageBox(NULL, (L"Unexpected configuration key: " + key + L" on line " + std::to_wstring(lineNumber) + L". Reacquire the launch configuration file from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-            exit(1);
+            errors.push_back(L"Failed to convert entry number for reading in UCS file: " + filePath + L"\nLine: " + std::to_wstring(lineNumber) + L": " + std::wstring(entryStart, lineEnd));
+            continue;
         }
 
-        requiredKeys.erase(key);
+        keys.push_back({ static_cast<uint32_t>(currentNumber), static_cast<uint32_t>(lineNumber) });
     }
-    configFile.close();
 
-    if (!requiredKeys.empty())
+    // the index is sorted once, after which duplicates are adjacent and gaps show between neighbours
+    std::sort(keys.begin(), keys.end());
+    return errors.size() == initialErrorCount;
+}
+
+// function to process individual UCS files, scanning well-formed files in place and writing a file back at most once if it has to be normalized
+bool ProcessUCSFile(const std::wstring& filePath, UCSFileResult& result)
+{
+    TRACE_SCOPE("ProcessUCSFile", filePath);
+    std::vector<std::wstring>& errors = result.errors;
+    MappedFile mappedFile;
+    if (!MapPortableFile(filePath.c_str(), mappedFile))
     {
-        std::wstring errorMsg = L"Missing or misspelled configuration keys: ";
-        for (const auto& key : requiredKeys)
-        {
-            errorMsg += key + L", ";
-        }
+        errors.push_back(L"Failed to open UCS file. Reacquire it from the mod package: " + filePath);
+        return false;
+    }
 
-        // remove the last comma and space
-        if (!requiredKeys.empty())
+    // a file that is already UTF-16 LE with CRLF line breaks is validated straight from the mapped view, without copying it
+    if (mappedFile.size >= 2 && mappedFile.data[0] == 0xFF && mappedFile.data[1] == 0xFE)
+    {
+        const char16_t* begin = reinterpret_cast<const char16_t*>(mappedFile.data + 2);
+        const char16_t* end = begin + (mappedFile.size - 2) / sizeof(char16_t);
+        if (CountBareLineBreaks(begin, end) == 0)
         {
-            errorMsg = errorMsg.substr(0, errorMsg.length() - 2);
+            bool valid = ScanUCSEntries(begin, end, filePath, result.keys, errors);
+            UnmapPortableFile(mappedFile);
+            return valid;
         }
-
-        MessageBox(NULL, errorMsg.c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-        exit(1);
     }
 
-    return config;
-}
+    // the view is released before the file is rewritten, as a mapped file cannot be replaced on Windows
+    std::string rawContent(reinterpret_cast<const char*>(mappedFile.data), mappedFile.size);
+    UnmapPortableFile(mappedFile);
 
-// function to write the launch configuration
-void WriteLaunchConfig(const LaunchConfig& config)
-{
-    wchar_t launcherPath[MAX_PATH];
-    GetModuleFileName(NULL, launcherPath, MAX_PATH);
+    TextEncoding encoding = DetectTextEncoding(rawContent);
+    std::u16string content;
 
-    std::wstring configFilePath = launcherPath;
-    size_t lastDotPos = configFilePath.find_last_of(L".");
-    if (lastDotPos != std::wstring::npos)
+    try
     {
-        configFilePath.replace(lastDotPos, std::wstring::npos, L".launchconfig");
+        DecodeToUTF16(rawContent, encoding, content);
+    }
+    catch (const std::exception& e)
+    {
+        errors.push_back(L"Failed to convert UCS file to UTF-16 LE. Try again, or reacquire it from the mod package: " + filePath + L"\nException: " + std::wstring(e.what(), e.what() + strlen(e.what())));
+        return false;
     }
+    rawContent.clear();
+    rawContent.shrink_to_fit();
 
-    std::wofstream configFile(configFilePath);
-    if (!configFile.is_open())
+    // the game requires UTF-16 LE with CRLF line breaks, anything else is normalized and written back in one go
+    NormalizeToCRLF(content);
+    if (!WriteUTF16LEFile(filePath, content))
     {
-        MessageBox(NULL, L"Failed to find or open the launch configuration file. Reacquire it from the mod package, or try again.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-        exit(1);
+        errors.push_back(L"Failed to verify or convert the " + filePath + L" file to the required UTF-16 LE and Windows (CRLF) format. Reacquire it from the mod package, or try again.");
+        return false;
     }
 
-    configFile << L"IsRetribution=" << (config.IsRetribution ? L"true" : L"false") << L"\n";
-    configFile << L"IsSteam=" << (config.IsSteam ? L"true" : L"false") << L"\n";
-    configFile << L"GameVersion=" << config.GameVersion << L"\n";
-    configFile << L"BinFolder=" << config.BinFolder << L"\n";
-    configFile << L"IsDXVK=" << (config.IsDXVK ? L"true" : L"false") << L"\n";
-    configFile << L"LAAPatch=" << (config.LAAPatch ? L"true" : L"false") << L"\n";
-    configFile << L"UIWarnings=" << (config.UIWarnings ? L"true" : L"false") << L"\n";
-    configFile << L"WIN7CompatibilityMode=" << (config.WIN7CompatibilityMode ? L"true" : L"false") << L"\n";
-    configFile << L"LaunchParams=" << config.LaunchParams << L"\n";
-    configFile << L"Injector=" << (config.Injector ? L"true" : L"false") << L"\n";
-    configFile << L"InjectorFileName=" << config.InjectorFileName << L"\n";
-    configFile << L"InjectedFiles=";
-    for (size_t i = 0; i < config.InjectedFiles.size(); ++i)
+    return ScanUCSEntries(content.data(), content.data() + content.size(), filePath, result.keys, errors);
+}
+
+// function to collect the UCS files of every locale directory, sorted by path so that reports are deterministic
+bool CollectUCSFiles(const std::wstring& localeDir, std::vector<std::wstring>& ucsFiles)
+{
+    WIN32_FIND_DATA findFileData;
+    HANDLE hFind = FindFirstFile((localeDir + L"\\*").c_str(), &findFileData);
+
+    if (hFind == INVALID_HANDLE_VALUE)
     {
-        configFile << config.InjectedFiles[i];
-        if (i < config.InjectedFiles.size() - 1)
-        {
-            configFile << L", ";
-        }
+        return false;
     }
-    configFile << L"\n";
-    configFile << L"InjectedConfigurations=";
-    for (size_t i = 0; i < config.InjectedConfigurations.size(); ++i)
+
+    do
     {
-        configFile << config.InjectedConfigurations[i];
-        if (i < config.InjectedConfigurations.size() - 1)
+        if (findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
         {
-            configFile << L", ";
+            std::wstring subDir = findFileData.cFileName;
+            if (subDir != L"." && subDir != L"..")
+            {
+                std::wstring fullPath = localeDir + L"\\" + subDir;
+                WIN32_FIND_DATA fileFindData;
+                HANDLE hFileFind = FindFirstFile((fullPath + L"\\*.ucs").c_str(), &fileFindData);
+
+                if (hFileFind != INVALID_HANDLE_VALUE)
+                {
+                    do
+                    {
+                        // skip DOW2.ucs files
+                        if (fileFindData.cFileName == std::wstring(L"DOW2.ucs"))
+                        {
+                            continue;
+                        }
+
+                        ucsFiles.push_back(fullPath + L"\\" + fileFindData.cFileName);
+                    }
+                    while (FindNextFile(hFileFind, &fileFindData) != 0);
+
+                    FindClose(hFileFind);
+                }
+            }
         }
     }
-    configFile << L"\n";
-    configFile << L"AdditionalFiles=";
-    for (size_t i = 0; i < config.AdditionalFiles.size(); ++i)
+    while (FindNextFile(hFind, &findFileData) != 0);
+
+    FindClose(hFind);
+    std::sort(ucsFiles.begin(), ucsFiles.end());
+    return true;
+}
+
+// function to find keys defined more than once within a UCS file
+void FindDuplicateUCSKeys(const std::wstring& filePath, const std::vector<UCSKeyEntry>& keys, std::vector<std::wstring>& warnings)
+{
+    size_t i = 0;
+    while (i < keys.size())
     {
-        configFile << config.AdditionalFiles[i];
-        if (i < config.AdditionalFiles.size() - 1)
+        size_t groupEnd = i + 1;
+        while (groupEnd < keys.size() && keys[groupEnd].key == keys[i].key)
         {
-            configFile << L", ";
+            ++groupEnd;
         }
-    }
-    configFile << L"\n";
-    configFile << L"FirstTimeLaunchCheck=" << (config.FirstTimeLaunchCheck ? L"true" : L"false") << L"\n";
-    configFile << L"FirstTimeLaunchMessage=" << config.FirstTimeLaunchMessage << L"\n";
-    configFile << L"VerboseDebug=" << (config.VerboseDebug ? L"true" : L"false") << L"\n";
-    configFile << L"Warnings=" << (config.Warnings ? L"true" : L"false") << L"\n";
-    configFile << L"IgnoredWarnings=";
-    for (auto it = config.IgnoredWarnings.begin(); it != config.IgnoredWarnings.end(); ++it)
-    {
-        if (it != config.IgnoredWarnings.begin())
+
+        if (groupEnd - i > 1)
         {
-            configFile << L", ";
+            std::wstring lines;
+            for (size_t j = i; j < groupEnd; ++j)
+            {
+                lines += (j == i ? L"" : L", ") + std::to_wstring(keys[j].line);
+            }
+            warnings.push_back(L"Duplicate key in UCS file: " + filePath + L"\nKey: " + std::to_wstring(keys[i].key) + L", lines: " + lines);
         }
-        configFile << *it;
+        i = groupEnd;
     }
-    configFile << L"\n";
-    configFile << L"IsUnsafe=" << (config.IsUnsafe ? L"true" : L"false") << L"\n";
-    configFile << L"Console=" << (config.Console ? L"true" : L"false") << L"\n";
-
-    configFile.close();
 }
 
-// function to read the injector mod folder
-std::wstring ReadModFolderFromConfig(const std::wstring& configFilePath)
+// function to find keys defined in more than one UCS file of the same locale directory
+void FindCollidingUCSKeys(const std::vector<std::wstring>& ucsFiles, const std::vector<UCSFileResult>& results, size_t firstFile, size_t lastFile, std::vector<std::wstring>& warnings)
 {
-    std::wifstream configFile(configFilePath);
-    if (!configFile.is_open())
+    // pairs of key and file index, with each key taken once per file
+    std::vector<std::pair<uint32_t, uint32_t>> localeKeys;
+    for (size_t fileIndex = firstFile; fileIndex < lastFile; ++fileIndex)
     {
-        MessageBox(NULL, (L"Failed to find or open the mod's " + configFilePath + L" injector config file. Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-        exit(1);
+        const auto& keys = results[fileIndex].keys;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (i == 0 || keys[i].key != keys[i - 1].key)
+            {
+                localeKeys.push_back({ keys[i].key, static_cast<uint32_t>(fileIndex) });
+            }
+        }
     }
+    std::sort(localeKeys.begin(), localeKeys.end());
 
-    std::wstring line;
-    std::wstring modFolder;
-    while (std::getline(configFile, line))
+    size_t i = 0;
+    while (i < localeKeys.size())
     {
-        size_t pos = line.find(L":");
-        if (pos == std::wstring::npos) continue;
-
-        std::wstring key = line.substr(0, pos);
-        std::wstring value = line.substr(pos + 1);
+        size_t groupEnd = i + 1;
+        while (groupEnd < localeKeys.size() && localeKeys[groupEnd].first == localeKeys[i].first)
+        {
+            ++groupEnd;
+        }
 
-        if (key == L"mod-folder")
+        if (groupEnd - i > 1)
         {
-            modFolder = TrimWString(value);
-            break;
+            std::wstring locations;
+            for (size_t j = i; j < groupEnd; ++j)
+            {
+                const auto& keys = results[localeKeys[j].second].keys;
+                auto entry = std::lower_bound(keys.begin(), keys.end(), UCSKeyEntry{ localeKeys[j].first, 0 });
+                locations += L"\n" + ucsFiles[localeKeys[j].second] + L" (line " + std::to_wstring(entry->line) + L")";
+            }
+            warnings.push_back(L"Key defined in more than one UCS file of the same language: " + std::to_wstring(localeKeys[i].first) + locations);
         }
+        i = groupEnd;
     }
-    configFile.close();
-
-    return modFolder;
 }
 
-// function to handle the binary processing with a timeout
-bool InjectorBinaryProcessing(const LaunchConfig& config, const std::wstring& launcherName)
+// function to describe the ranges of keys missing between the first and last key of a UCS file
+std::wstring DescribeUCSKeyGaps(const std::vector<UCSKeyEntry>& keys)
 {
-    std::string actualChecksum, expectedChecksum;
-
-    // Construct the injector bin file name using the launcher name and _injectorfilename from the configuration
-    std::wstring binFileName = config.BinFolder + L"\\" + launcherName + L"_" + config.InjectorFileName.substr(0, config.InjectorFileName.find_last_of(L".")) + L".bin";
-
-    // calculate the expected checksum from the .bin file
-    if (!CalculateMD5(binFileName.c_str(), expectedChecksum))
-    {
-        std::wstringstream errorMessage;
-        errorMessage << L"Failed to calculate the MD5 checksum of the " << binFileName << L" file in order to validate the injector. The file may be missing. Reacquire it from the mod package, or try again.";
-        MessageBox(NULL, errorMessage.str().c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-        return false;
-    }
-
-    // calculate the actual checksum of the injector file
-    if (CalculateMD5(config.InjectorFileName.c_str(), actualChecksum) && actualChecksum != expectedChecksum)
+    std::wstring gaps;
+    size_t gapCount = 0;
+    for (size_t i = 1; i < keys.size(); ++i)
     {
-        if (!CopyFileRaw(binFileName.c_str(), config.InjectorFileName.c_str()))
+        uint32_t previousKey = keys[i - 1].key;
+        if (keys[i].key - previousKey <= 1)
         {
-            std::wstringstream errorMessage;
-            errorMessage << L"Failed to replace the " << config.InjectorFileName << L" file with the valid injector version for this mod. The file " << binFileName << L" may be missing. Reacquire it from the mod package, or try again.";
-            MessageBox(NULL, errorMessage.str().c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-            return false;
+            continue;
         }
 
-        // verify the checksum again after replacement
-        if (CalculateMD5(config.InjectorFileName.c_str(), actualChecksum) && actualChecksum != expectedChecksum)
+        if (gapCount < MAX_REPORTED_ERRORS)
         {
-            std::wstringstream errorMessage;
-            errorMessage << config.InjectorFileName << L" file MD5 checksum still mismatched after attempted replacement with the valid injector version for this mod. Reacquire it from the mod package, or try again.";
-            MessageBox(NULL, errorMessage.str().c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-            return false;
+            gaps += (gapCount == 0 ? L"" : L", ") + std::to_wstring(previousKey + 1);
+            if (keys[i].key - 1 > previousKey + 1)
+            {
+                gaps += L"-" + std::to_wstring(keys[i].key - 1);
+            }
         }
+        ++gapCount;
     }
-    return true;
+
+    if (gapCount > MAX_REPORTED_ERRORS)
+    {
+        gaps += L" and " + std::to_wstring(gapCount - MAX_REPORTED_ERRORS) + L" more";
+    }
+    return gaps;
+}
+
+// function to join a list of messages into one, listing at most MAX_REPORTED_ERRORS of them
+std::wstring JoinReportedMessages(const std::vector<std::wstring>& messages, const std::wstring& remainderLabel)
+{
+    std::wstringstream joinedMessage;
+    for (size_t i = 0; i < messages.size() && i < MAX_REPORTED_ERRORS; ++i)
+    {
+        joinedMessage << messages[i] << L"\n\n";
+    }
+    if (messages.size() > MAX_REPORTED_ERRORS)
+    {
+        joinedMessage << L"... and " << (messages.size() - MAX_REPORTED_ERRORS) << L" more " << remainderLabel << L".";
+    }
+    return joinedMessage.str();
 }
 
-// function to process individual UCS files
-bool ProcessUCSFile(const std::wstring& filePath)
+// function to validate the formatting of ucs files, processing the files on worker threads and reporting every error at once
+bool ValidateUCSFiles(const std::wstring& rootDir, LaunchConfig& config)
 {
-    std::ifstream ucsFile(filePath, std::ios::binary);
+    TRACE_SCOPE("ValidateUCSFiles");
+    std::wstring localeDir = rootDir + L"\\GameAssets\\Locale";
+    std::vector<std::wstring> ucsFiles;
 
-    if (!ucsFile.is_open())
+    if (!CollectUCSFiles(localeDir, ucsFiles))
     {
-        MessageBox(NULL, (L"Failed to open UCS file. Reacquire it from the mod package: " + filePath).c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+        MessageBox(NULL, L"Failed to find or open any locale directories. Verify your game cache and reacquire the necessary files from the mod package.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
         return false;
     }
 
-    if (!CheckAndConvertToWindowsCRLF(filePath))
+    // every file collects its own results, so the report keeps the sorted file order regardless of which worker finished first
+    std::vector<UCSFileResult> results(ucsFiles.size());
+    ParallelFor(ucsFiles.size(), [&ucsFiles, &results](size_t index)
+        {
+            ProcessUCSFile(ucsFiles[index], results[index]);
+        });
+
+    std::vector<std::wstring> errors;
+    for (const auto& result : results)
+    {
+        errors.insert(errors.end(), result.errors.begin(), result.errors.end());
+    }
+
+    if (!errors.empty())
     {
-        MessageBox(NULL, (L"Failed to verify or convert the " + filePath + L" file to the required Windows (CRLF) format. Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+        MessageBox(NULL, JoinReportedMessages(errors, L"errors").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
         return false;
     }
 
-    // read entire file content into a string
-    std::string fileContent((std::istreambuf_iterator<char>(ucsFile)), std::istreambuf_iterator<char>());
-    ucsFile.close();
+    std::wstring warningKey = L"UCSKeys";
+    if (config.Warnings && config.IgnoredWarnings.find(warningKey) == config.IgnoredWarnings.end())
+    {
+        std::vector<std::wstring> warnings;
+        for (size_t i = 0; i < ucsFiles.size(); ++i)
+        {
+            FindDuplicateUCSKeys(ucsFiles[i], results[i].keys, warnings);
+        }
 
-    std::wstring wFileContent;
-    bool conversionNeeded = false;
+        // the files are sorted by path, so the files of each locale directory are next to each other
+        size_t firstFile = 0;
+        while (firstFile < ucsFiles.size())
+        {
+            std::wstring language = ucsFiles[firstFile].substr(0, ucsFiles[firstFile].find_last_of(L'\\'));
+            size_t lastFile = firstFile + 1;
+            while (lastFile < ucsFiles.size() && ucsFiles[lastFile].substr(0, ucsFiles[lastFile].find_last_of(L'\\')) == language)
+            {
+                ++lastFile;
+            }
+            FindCollidingUCSKeys(ucsFiles, results, firstFile, lastFile, warnings);
+            firstFile = lastFile;
+        }
 
-    try
-    {
-        if (fileContent.size() > 2 && (unsigned char)fileContent[0] == 0xFF && (unsigned char)fileContent[1] == 0xFE)
+        if (!warnings.empty())
         {
-            // UTF-16 LE BOM detected
-            wFileContent.assign(reinterpret_cast<const wchar_t*>(fileContent.data() + 2), (fileContent.size() - 2) / sizeof(wchar_t));
+            std::wstring warningMessage = JoinReportedMessages(warnings, L"warnings") + L"The game only uses one of the conflicting entries. Would you like to keep being warned about conflicting UCS keys?";
+            int msgboxID = MessageBox(NULL, warningMessage.c_str(), L"Warning", MB_YESNO | MB_ICONWARNING | MB_SETFOREGROUND | MB_TOPMOST);
+            if (msgboxID == IDNO)
+            {
+                config.IgnoredWarnings.insert(warningKey);
+                MarkLaunchConfigDirty(L"IgnoredWarnings");
+            }
         }
-        else if (fileContent.size() > 2 && (unsigned char)fileContent[0] == 0xEF && (unsigned char)fileContent[1] == 0xBB && (unsigned char)fileContent[2] == 0xBF)
+    }
+
+    if (config.VerboseDebug)
+    {
+        std::vector<std::wstring> gapReports;
+        for (size_t i = 0; i < ucsFiles.size(); ++i)
         {
-            // UTF-8 BOM detected
-            std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> conv;
-            wFileContent = conv.from_bytes(fileContent.substr(3));
-            conversionNeeded = true;
+            std::wstring gaps = DescribeUCSKeyGaps(results[i].keys);
+            if (!gaps.empty())
+            {
+                gapReports.push_back(L"Key gaps in UCS file: " + ucsFiles[i] + L"\nMissing: " + gaps);
+            }
         }
-        else
+
+        if (!gapReports.empty())
         {
-            // no BOM or unknown BOM, assume UTF-8 without BOM
-            std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> conv;
-            wFileContent = conv.from_bytes(fileContent);
-            conversionNeeded = true;
+            MessageBox(NULL, JoinReportedMessages(gapReports, L"files with gaps").c_str(), L"Debug", MB_OK | MB_ICONINFORMATION | MB_SETFOREGROUND | MB_TOPMOST);
         }
     }
-    catch (const std::exception& e)
+
+    return true;
+}
+
+// structure to hold an archive or folder entry of a .module file
+struct ModuleEntry
+{
+    std::wstring section;
+    unsigned int index = 0;
+    std::wstring path;
+};
+
+// structure to hold the parsed contents of a .module file
+struct ModuleManifest
+{
+    std::wstring name;
+    std::vector<std::wstring> sections;
+    std::vector<ModuleEntry> archives;
+    std::vector<ModuleEntry> folders;
+};
+
+// function to trim spaces and tabs from both ends of a range of UTF-16 text
+void TrimUTF16Range(const char16_t*& begin, const char16_t*& end)
+{
+    while (begin < end && (*begin == u' ' || *begin == u'\t'))
     {
-        std::wstring errorMessage = L"Failed to convert UCS file to UTF-16 LE. Try again, or reacquire it from the mod package: " + filePath + L"\nException: " + std::wstring(e.what(), e.what() + strlen(e.what()));
-        MessageBox(NULL, errorMessage.c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-        return false;
+        ++begin;
+    }
+    while (end > begin && (end[-1] == u' ' || end[-1] == u'\t'))
+    {
+        --end;
     }
+}
 
-    if (conversionNeeded)
+// function to match a key of the form prefix.NN, returning the number
+bool ParseIndexedModuleKey(const char16_t* keyBegin, const char16_t* keyEnd, const char16_t* prefix, unsigned int& index)
+{
+    const char16_t* current = keyBegin;
+    while (*prefix != u'\0')
     {
-        // convert to UTF-16 LE and write back to the file
-        std::ofstream outFile(filePath, std::ios::binary | std::ios::trunc);
-        if (!outFile.is_open())
+        if (current == keyEnd || towlower(*current) != *prefix)
         {
-            MessageBox(NULL, (L"Failed to find or open faulty UCS file. Try again, or reacquire it from the mod package: " + filePath).c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
             return false;
         }
-
-        // write BOM for UTF-16 LE
-        char16_t bom = 0xFEFF;
-        outFile.write(reinterpret_cast<const char*>(&bom), sizeof(bom));
-
-        // write the converted content
-        outFile.write(reinterpret_cast<const char*>(wFileContent.data()), wFileContent.size() * sizeof(wchar_t));
-        outFile.close();
+        ++current;
+        ++prefix;
     }
 
-    // re-read the file to ensure it's now UTF-16 LE
-    ucsFile.open(filePath, std::ios::binary);
-    if (!ucsFile.is_open())
+    if (current == keyEnd)
     {
-        MessageBox(NULL, (L"Failed to find or open faulty UCS file to confirm attempted conversion to UTF-16 LE. Try again, or reacquire it from the mod package: " + filePath).c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
         return false;
     }
 
-    std::string newFileContent((std::istreambuf_iterator<char>(ucsFile)), std::istreambuf_iterator<char>());
-    ucsFile.close();
-
-    if (!(newFileContent.size() > 2 && (unsigned char)newFileContent[0] == 0xFF && (unsigned char)newFileContent[1] == 0xFE))
+    index = 0;
+    for (; current < keyEnd; ++current)
     {
-        std::wstring errorMessage = L"UCS file could not be verified as UTF-16 LE after attempted conversion: " + filePath;
-        MessageBox(NULL, errorMessage.c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-        return false;
+        if (*current < u'0' || *current > u'9' || index > 99999)
+        {
+            return false;
+        }
+        index = index * 10 + (*current - u'0');
     }
+    return true;
+}
 
-    std::wstringstream wss(wFileContent);
-    std::unordered_map<unsigned long, std::vector<int>> numberLineMap;
-    std::wstring line;
-    unsigned long currentNumber = 0;
-    int lineNumber = 0;
+// function to parse a .module file in a single pass, collecting its name, sections, archives and folders
+void ParseModuleManifest(const char16_t* begin, const char16_t* end, ModuleManifest& manifest)
+{
+    std::wstring currentSection;
+    const char16_t* lineStart = begin;
 
-    while (std::getline(wss, line))
+    while (lineStart < end)
     {
-        lineNumber++;
+        const char16_t* lineEnd = FindLineBreak(lineStart, end);
+        const char16_t* nextLineStart = lineEnd;
+        while (nextLineStart < end && (*nextLineStart == u'\r' || *nextLineStart == u'\n'))
+        {
+            ++nextLineStart;
+        }
 
-        size_t firstNonWhitespace = line.find_first_not_of(L" \t");
+        const char16_t* current = lineStart;
+        lineStart = nextLineStart;
+        TrimUTF16Range(current, lineEnd);
 
-        // allow empty lines and lines with only carriage returns or newlines
-        if (line.empty() || line == L"\r" || line == L"\n" || line == L"\r\n")
+        // skip empty lines and comments
+        if (current == lineEnd || *current == u';' || *current == u'#')
         {
             continue;
         }
 
-        // check if the line is entirely whitespace
-        if (firstNonWhitespace == std::wstring::npos)
+        if (*current == u'[')
         {
-            std::wstring errorMessage = L"Whitespace entry in UCS file: " + filePath + L"\nLine: " + std::to_wstring(lineNumber);
-            MessageBox(NULL, errorMessage.c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-            return false;
+            const char16_t* sectionEnd = current + 1;
+            while (sectionEnd < lineEnd && *sectionEnd != u']')
+            {
+                ++sectionEnd;
+            }
+            currentSection.assign(current + 1, sectionEnd);
+            manifest.sections.push_back(currentSection);
+            continue;
         }
 
-        // remove leading whitespace
-        line = line.substr(firstNonWhitespace);
-
-        // if no digits found at the start of the line
-        if (!iswdigit(line[0]))
+        const char16_t* separator = current;
+        while (separator < lineEnd && *separator != u'=')
         {
-            std::wstring errorMessage = L"Not a numeric entry in UCS file: " + filePath + L"\nLine: " + std::to_wstring(lineNumber) + L": " + line;
-            MessageBox(NULL, errorMessage.c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-            return false;
+            ++separator;
+        }
+        if (separator == lineEnd)
+        {
+            continue;
         }
 
-        size_t firstNonDigitPos = line.find_first_not_of(L"0123456789");
-
-        // if the number part is found, extract it
-        std::wstring numberPart = line.substr(0, firstNonDigitPos);
-        std::wstring textPart = line.substr(firstNonDigitPos);
+        const char16_t* keyBegin = current;
+        const char16_t* keyEnd = separator;
+        const char16_t* valueBegin = separator + 1;
+        const char16_t* valueEnd = lineEnd;
+        TrimUTF16Range(keyBegin, keyEnd);
+        TrimUTF16Range(valueBegin, valueEnd);
 
-        // ensure the number part is purely numeric
-        if (!std::all_of(numberPart.begin(), numberPart.end(), iswdigit))
+        unsigned int index = 0;
+        if (keyEnd - keyBegin == 4 && std::char_traits<char16_t>::compare(keyBegin, u"Name", 4) == 0)
         {
-            std::wstring errorMessage = L"Not a numeric entry in UCS file: " + filePath + L"\nLine: " + std::to_wstring(lineNumber) + L": " + line;
-            MessageBox(NULL, errorMessage.c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-            return false;
+            manifest.name.assign(valueBegin, valueEnd);
         }
-
-        try
+        else if (ParseIndexedModuleKey(keyBegin, keyEnd, u"archive.", index))
         {
-            currentNumber = std::stoul(numberPart);
+            manifest.archives.push_back({ currentSection, index, std::wstring(valueBegin, valueEnd) });
         }
-        catch (const std::exception& e)
+        else if (ParseIndexedModuleKey(keyBegin, keyEnd, u"folder.", index))
         {
-            std::wstring errorMessage = L"Failed to convert entry number for reading in UCS file: " + filePath + L"\nLine: " + std::to_wstring(lineNumber) + L": " + line + L"\nException: " + std::wstring(e.what(), e.what() + strlen(e.what()));
-            MessageBox(NULL, errorMessage.c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-            return false;
+            manifest.folders.push_back({ currentSection, index, std::wstring(valueBegin, valueEnd) });
         }
-
-        numberLineMap[currentNumber].push_back(lineNumber);
     }
-
-    return true;
 }
 
-// function to validate the formatting of ucs files
-bool ValidateUCSFiles(const std::wstring& rootDir)
-{
-    WIN32_FIND_DATA findFileData;
-    std::wstring localeDir = rootDir + L"\\GameAssets\\Locale";
-    HANDLE hFind = FindFirstFile((localeDir + L"\\*").c_str(), &findFileData);
-
-    if (hFind == INVALID_HANDLE_VALUE)
-    {
-        MessageBox(NULL, L"Failed to find or open any locale directories. Verify your game cache and reacquire the necessary files from the mod package.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-        return false;
-    }
-    
-    do
-    {
-        if (findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-        {
-            std::wstring subDir = findFileData.cFileName;
-            if (subDir != L"." && subDir != L"..")
-            {
-                std::wstring fullPath = localeDir + L"\\" + subDir;
-                WIN32_FIND_DATA fileFindData;
-                HANDLE hFileFind = FindFirstFile((fullPath + L"\\*.ucs").c_str(), &fileFindData);
-
-                if (hFileFind != INVALID_HANDLE_VALUE)
-                {
-                    do
-                    {
-                        std::wstring filePath = fullPath + L"\\" + fileFindData.cFileName;
+// function to get the language folder name of a path under GameAssets\Locale, or an empty string for any other path
+std::wstring GetLocaleFolderName(const std::wstring& relativePath)
+{
+    const std::wstring localePrefix = L"GameAssets\\Locale\\";
+    if (relativePath.size() <= localePrefix.size() || !boost::algorithm::istarts_with(relativePath, localePrefix))
+    {
+        return L"";
+    }
 
-                        // skip DOW2.ucs files
-                        if (fileFindData.cFileName == std::wstring(L"DOW2.ucs"))
-                        {
-                            continue;
-                        }
+    size_t folderEnd = relativePath.find(L'\\', localePrefix.size());
+    if (folderEnd == std::wstring::npos || folderEnd == localePrefix.size())
+    {
+        return L"";
+    }
+    return relativePath.substr(localePrefix.size(), folderEnd - localePrefix.size());
+}
 
-                        if (!ProcessUCSFile(filePath))
-                        {
-                            FindClose(hFileFind);
-                            FindClose(hFind);
-                            return false;
-                        }
-                    } 
-                    while (FindNextFile(hFileFind, &fileFindData) != 0);
+// function to check whether a .module archive entry refers to an .sga archive
+bool IsSgaArchivePath(const std::wstring& path)
+{
+    return boost::algorithm::iends_with(path, L".sga");
+}
 
-                    FindClose(hFileFind);
-                }
-            }
-        }
-    } 
-    while (FindNextFile(hFind, &findFileData) != 0);
+// structure to hold an archive required by the module and the outcome of its checks
+struct ArchiveCheck
+{
+    std::wstring path;
+    unsigned long long fileSize = 0;
+    unsigned long long lastWriteTime = 0;
+    std::string headerDigest;
+    std::wstring problem;
+};
 
-    FindClose(hFind);
-    return true;
+// function to validate the header of a required archive, reading its metadata first so a change during the check is caught on the next launch
+void ValidateArchiveCheck(ArchiveCheck& check)
+{
+    if (!GetFileMetadata(check.path.c_str(), check.fileSize, check.lastWriteTime))
+    {
+        check.problem = L"the file could not be opened";
+        return;
+    }
+    ValidateSgaArchive(check.path.c_str(), check.problem, check.headerDigest);
 }
 
 // function to check integrity of the required archives
-bool CheckModuleFile(const std::wstring& moduleFileName, const LaunchConfig& config, const std::wstring& launcherName)
+bool CheckModuleFile(const std::wstring& rootDir, const std::wstring& moduleFileName, const LaunchConfig& config, const std::wstring& launcherName, SgaVerificationLevel verificationLevel)
 {
-    std::wifstream moduleFile(moduleFileName);
-    if (!moduleFile.is_open())
+    TRACE_SCOPE("CheckModuleFile", moduleFileName);
+    if (!PathExists(moduleFileName))
     {
-        MessageBox(NULL, (L"Failed to find or open the mod's " + moduleFileName + L" module file. Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+        ReportError(L"Failed to find or open the mod's " + moduleFileName + L" module file. Reacquire it from the mod package, or try again.");
         return false;
     }
 
-    if (!CheckAndConvertToWindowsCRLF(moduleFileName))
+    // the file is read once, the text returned by the line ending check is what gets parsed
+    std::u16string moduleContent;
+    if (!CheckAndConvertToWindowsCRLF(moduleFileName, moduleContent))
     {
-        MessageBox(NULL, (L"Failed to verify or convert the " + moduleFileName + L" file to the required Windows (CRLF) format. Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+        ReportError(L"Failed to verify or convert the " + moduleFileName + L" file to the required Windows (CRLF) format. Reacquire it from the mod package, or try again.");
         return false;
     }
 
-    std::wstring line;
-    std::wregex archiveRegex(L"archive\\.\\d{2} = (.+\\.sga)");
-    std::wsmatch match;
-    wchar_t launcherPath[MAX_PATH];
-    GetModuleFileName(NULL, launcherPath, MAX_PATH);
-    std::wstring rootDir = std::wstring(launcherPath).substr(0, std::wstring(launcherPath).find_last_of(L"\\/"));
+    ModuleManifest manifest;
+    ParseModuleManifest(moduleContent.data(), moduleContent.data() + moduleContent.size(), manifest);
 
+    // detect language folders with DOW2.ucs
     std::set<std::wstring> localeFoldersWithUcs;
-    std::wregex localeRegex(L"^GameAssets\\\\Locale\\\\([^\\\\]+)\\\\");
-    std::wsmatch localeMatch;
-    std::wstring moduleName;
-
-    while (std::getline(moduleFile, line))
+    for (const auto& archive : manifest.archives)
     {
-        // extract the Name field
-        std::wregex nameRegex(L"^Name\\s*=\\s*(.+)$");
-        if (std::regex_search(line, match, nameRegex))
+        std::wstring localeFolderName = GetLocaleFolderName(archive.path);
+        if (IsSgaArchivePath(archive.path) && !localeFolderName.empty())
         {
-            moduleName = match[1].str();
-        }
-
-        // first pass to detect language folders with DOW2.ucs
-        if (std::regex_search(line, match, archiveRegex))
-        {
-            std::wstring relativePath = match[1].str();
-            std::wstring fullPath = rootDir + L"\\" + relativePath;
+            std::wstring localeFolder = rootDir + L"\\GameAssets\\Locale\\" + localeFolderName;
+            std::wstring ucsFile = localeFolder + L"\\DOW2.ucs";
 
-            if (std::regex_search(relativePath, localeMatch, localeRegex))
+            if (PathExists(ucsFile))
             {
-                std::wstring localeFolder = rootDir + L"\\GameAssets\\Locale\\" + localeMatch[1].str();
-                std::wstring ucsFile = localeFolder + L"\\DOW2.ucs";
-
-                if (GetFileAttributes(ucsFile.c_str()) != INVALID_FILE_ATTRIBUTES)
-                {
-                    localeFoldersWithUcs.insert(localeFolder);
-                }
+                localeFoldersWithUcs.insert(localeFolder);
             }
         }
     }
 
     // check if the module Name matches the launcher name
-    if (moduleName != launcherName)
+    if (manifest.name != launcherName)
     {
-        MessageBox(NULL, (L"The [Name] field of the " + moduleFileName + L" file does not match the mod name " + launcherName + L". Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+        ReportError(L"The [Name] field of the " + moduleFileName + L" file does not match the mod name " + launcherName + L". Reacquire it from the mod package, or try again.");
         return false;
     }
 
@@ -887,49 +1476,85 @@ bool CheckModuleFile(const std::wstring& moduleFileName, const LaunchConfig& con
 
     if (!hasFiles)
     {
-        MessageBox(NULL, L"No localization files were found under the GameAssets/Locale directory. Verify your game cache and reacquire the necessary files from the mod package.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+        ReportError(L"No localization files were found under the GameAssets/Locale directory. Verify your game cache and reacquire the necessary files from the mod package.");
         return false;
     }
 
     bool skipLocaleSgaChecks = (localeFoldersWithUcs.size() > 1);
+    std::vector<ArchiveCheck> archiveChecks;
 
-    // reset file reading position for the second pass
-    moduleFile.clear();
-    moduleFile.seekg(0, std::ios::beg);
-
-    // second pass to perform .sga checks
-    while (std::getline(moduleFile, line))
+    // perform .sga checks
+    for (const auto& archive : manifest.archives)
     {
-        if (std::regex_search(line, match, archiveRegex))
+        if (!IsSgaArchivePath(archive.path))
         {
-            std::wstring relativePath = match[1].str();
-            std::wstring fullPath = rootDir + L"\\" + relativePath;
+            continue;
+        }
 
-            if (std::regex_search(relativePath, localeMatch, localeRegex))
+        std::wstring fullPath = rootDir + L"\\" + archive.path;
+        std::wstring localeFolderName = GetLocaleFolderName(archive.path);
+
+        if (!localeFolderName.empty())
+        {
+            if (skipLocaleSgaChecks)
             {
-                if (skipLocaleSgaChecks)
-                {
-                    continue; // skip .sga file checks in Locale subfolders
-                }
-                else
-                {
-                    std::wstring localeFolder = rootDir + L"\\GameAssets\\Locale\\" + localeMatch[1].str();
-                    std::wstring ucsFile = localeFolder + L"\\DOW2.ucs";
+                continue; // skip .sga file checks in Locale subfolders
+            }
+            else
+            {
+                std::wstring localeFolder = rootDir + L"\\GameAssets\\Locale\\" + localeFolderName;
+                std::wstring ucsFile = localeFolder + L"\\DOW2.ucs";
 
-                    if (GetFileAttributes(localeFolder.c_str()) == INVALID_FILE_ATTRIBUTES || GetFileAttributes(ucsFile.c_str()) == INVALID_FILE_ATTRIBUTES)
-                    {
-                        // Locale folder or DOW2.ucs file does not exist, we skip this .sga file check
-                        continue;
-                    }
+                if (!PathExists(localeFolder) || !PathExists(ucsFile))
+                {
+                    // Locale folder or DOW2.ucs file does not exist, we skip this .sga file check
+                    continue;
                 }
             }
+        }
+
+        if (!PathExists(fullPath))
+        {
+            ReportError(L"Missing archive " + fullPath + L" required by this mod. Reacquire it from the mod package, or try again.");
+            return false;
+        }
+        if (verificationLevel != SgaVerificationLevel::None)
+        {
+            ArchiveCheck check;
+            check.path = fullPath;
+            archiveChecks.push_back(check);
+        }
+    }
+
+    // validate the headers and tables of contents of the existing archives, the payload is never read
+    ParallelFor(archiveChecks.size(), [&archiveChecks](size_t index)
+        {
+            ValidateArchiveCheck(archiveChecks[index]);
+        });
+
+    for (const auto& check : archiveChecks)
+    {
+        if (!check.problem.empty())
+        {
+            ReportError(L"Archive " + check.path + L" required by this mod is damaged (" + check.problem + L"). Reacquire it from the mod package, or try again.");
+            return false;
+        }
+    }
 
-            if (GetFileAttributes(fullPath.c_str()) == INVALID_FILE_ATTRIBUTES)
+    // full verification hashes every stored file, one archive at a time with each archive split across the worker threads
+    // archives fully verified on an earlier launch are skipped while their size, last write time and header are unchanged
+    for (const auto& check : archiveChecks)
+    {
+        if (verificationLevel == SgaVerificationLevel::Full && !IsArchiveVerified(check.path.c_str(), check.fileSize, check.lastWriteTime, check.headerDigest, verificationLevel))
+        {
+            std::wstring problem;
+            if (!VerifySgaArchiveContents(check.path.c_str(), problem))
             {
-                MessageBox(NULL, (L"Missing archive " + fullPath + L" required by this mod. Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+                ReportError(L"Archive " + check.path + L" required by this mod is damaged (" + problem + L"). Reacquire it from the mod package, or try again.");
                 return false;
             }
         }
+        StoreVerifiedArchive(check.path.c_str(), check.fileSize, check.lastWriteTime, check.headerDigest, verificationLevel);
     }
 
     return true;
@@ -1009,8 +1634,9 @@ void CheckGameConfiguration(const LaunchConfig& config)
 }
 
 // function to check additional files
-bool CheckAdditionalFiles(const LaunchConfig& config, const std::wstring& launcherName)
+bool CheckAdditionalFiles(const LaunchConfig& config, const std::wstring& launcherName, std::vector<FilePairCheck>& binFileChecks)
 {
+    TRACE_SCOPE("CheckAdditionalFiles");
     for (const auto& fileName : config.AdditionalFiles)
     {
         if (fileName.empty())
@@ -1021,10 +1647,9 @@ bool CheckAdditionalFiles(const LaunchConfig& config, const std::wstring& launch
         bool fileMissing = false;
 
         std::wstring filePath = fileName;
-        std::string actualChecksum, expectedChecksum;
         size_t lastDotPos = fileName.find_last_of(L'.');
         std::wstring baseFileName = (lastDotPos == std::wstring::npos) ? fileName : fileName.substr(0, lastDotPos);
-        std::wstring expectedFileName = config.BinFolder + L"\\" + launcherName + L"_" + baseFileName + L".bin";
+        std::wstring expectedFileName = GetBinFilePath(config, launcherName, baseFileName);
 
         // skip the checksum verification if the .bin file is only the launcher name with an underscore
         if (baseFileName == launcherName + L"_")
@@ -1032,45 +1657,50 @@ bool CheckAdditionalFiles(const LaunchConfig& config, const std::wstring& launch
             continue;
         }
 
-        if (GetFileAttributes(filePath.c_str()) == INVALID_FILE_ATTRIBUTES)
+        if (!PathExists(filePath))
         {
             fileMissing = true;
         }
 
         if (fileMissing)
         {
-            if (!CopyFileRaw(expectedFileName, fileName))
+            if (RestoreFileFromBaseline(expectedFileName, fileName) != RestoreResult::Restored)
             {
                 std::wstringstream errorMessage;
                 errorMessage << L"Failed to create or replace the " + fileName + L" file required by this mod. Reacquire it from the mod package, or try again.";
-                MessageBox(NULL, errorMessage.str().c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+                ReportError(errorMessage.str());
                 return false;
             }
+            InvalidateBinFileChecks(binFileChecks, filePath);
         }
 
-        if (!CalculateMD5(filePath.c_str(), actualChecksum))
+        FilePairCheck check = TakeBinFileCheck(binFileChecks, filePath, expectedFileName);
+
+        if (!check.fileReadable)
         {
-            MessageBox(NULL, (L"Failed to calculate the MD5 checksum of the " + fileName + L" file. It may be missing. Reacquire it from the mod package").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+            ReportError(L"Failed to calculate the MD5 checksum of the " + fileName + L" file. It may be missing. Reacquire it from the mod package");
             return false;
         }
 
-        if (!CalculateMD5(expectedFileName.c_str(), expectedChecksum))
+        if (!check.baselineReadable)
         {
-            MessageBox(NULL, (L"Failed to calculate MD5 checksum of the " + expectedFileName + L" file. It may be missing. Reacquire it from the mod package").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+            ReportError(L"Failed to calculate MD5 checksum of the " + expectedFileName + L" file. It may be missing. Reacquire it from the mod package");
             return false;
         }
 
-        if (actualChecksum != expectedChecksum)
+        if (!check.filesMatch)
         {
-            if (!CopyFileRaw(expectedFileName, filePath))
+            RestoreResult restoreResult = RestoreFileFromBaseline(expectedFileName, filePath);
+            if (restoreResult == RestoreResult::CopyFailed)
             {
-                MessageBox(NULL, (L"Failed to replace the " + fileName + L" file with the required version for this mod. Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+                ReportError(L"Failed to replace the " + fileName + L" file with the required version for this mod. Reacquire it from the mod package, or try again.");
                 return false;
             }
+            InvalidateBinFileChecks(binFileChecks, filePath);
 
-            if (CalculateMD5(filePath.c_str(), actualChecksum) && actualChecksum != expectedChecksum)
+            if (restoreResult == RestoreResult::Mismatched)
             {
-                MessageBox(NULL, (fileName + L" file MD5 checksum still mismatched after attempted replacement with the required version for this mod. Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+                ReportError(fileName + L" file MD5 checksum still mismatched after attempted replacement with the required version for this mod. Reacquire it from the mod package, or try again.");
                 return false;
             }
         }
@@ -1079,19 +1709,21 @@ bool CheckAdditionalFiles(const LaunchConfig& config, const std::wstring& launch
 }
 
 // function to verify XThread
-bool VerifyXThread(const LaunchConfig& config, const std::wstring& launcherName)
+bool VerifyXThread(const LaunchConfig& config, const std::wstring& launcherName, std::vector<FilePairCheck>& binFileChecks)
 {
+    TRACE_SCOPE("VerifyXThread");
     std::wstring dllPath = L"XThread.dll";
-    std::wstring binPath = config.BinFolder + L"\\" + launcherName + L"_XThread.bin";
-    std::string binMD5, currentMD5;
+    std::wstring binPath = GetBinFilePath(config, launcherName, L"XThread");
+    FilePairCheck check = TakeBinFileCheck(binFileChecks, dllPath, binPath);
 
-    if (CalculateMD5(binPath.c_str(), binMD5))
+    if (check.baselineReadable)
     {
-        if (GetFileAttributes(dllPath.c_str()) != INVALID_FILE_ATTRIBUTES)
+        if (PathExists(dllPath))
         {
-            if (CalculateMD5(dllPath.c_str(), currentMD5) && currentMD5 != binMD5)
+            if (check.fileReadable && !check.filesMatch)
             {
-                if (!CopyFileRaw(binPath, dllPath))
+                RestoreResult restoreResult = RestoreFileFromBaseline(binPath, dllPath);
+                if (restoreResult == RestoreResult::CopyFailed)
                 {
                     std::wstringstream errorMessage;
                     errorMessage << L"Failed to create or replace the XThread.dll file with the updated version that is required for the game to run on CPUs with more than twelve cores. The " << binPath << L" file may be missing. Reacquire it from the mod package, or try again.";
@@ -1099,7 +1731,7 @@ bool VerifyXThread(const LaunchConfig& config, const std::wstring& launcherName)
                     return false;
                 }
 
-                if (CalculateMD5(dllPath.c_str(), currentMD5) && currentMD5 != binMD5)
+                if (restoreResult == RestoreResult::Mismatched)
                 {
                     MessageBox(NULL, L"XThread.dll file MD5 checksum still mismatched after attempted replacement with the updated version that is required for the game to run on CPUs with more than twelve cores. Reacquire it from the mod package, or try again.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                     return false;
@@ -1118,8 +1750,9 @@ bool VerifyXThread(const LaunchConfig& config, const std::wstring& launcherName)
 }
 
 // function to verify DXVK
-bool VerifyDXVK(LaunchConfig& config, const std::wstring& launcherName)
+bool VerifyDXVK(LaunchConfig& config, const std::wstring& launcherName, std::vector<FilePairCheck>& binFileChecks)
 {
+    TRACE_SCOPE("VerifyDXVK");
     bool d3d9IsDXVK = false;
     bool d3d9Missing = false;
     bool dxvkConfMissing = false;
@@ -1127,12 +1760,12 @@ bool VerifyDXVK(LaunchConfig& config, const std::wstring& launcherName)
     if (config.IsDXVK)
     {
 
-        if (GetFileAttributes(L"d3d9.dll") == INVALID_FILE_ATTRIBUTES)
+        if (!PathExists(L"d3d9.dll"))
         {
             d3d9Missing = true;
         }
 
-        if (GetFileAttributes(L"dxvk.conf") == INVALID_FILE_ATTRIBUTES)
+        if (!PathExists(L"dxvk.conf"))
         {
             dxvkConfMissing = true;
         }
@@ -1149,13 +1782,14 @@ bool VerifyDXVK(LaunchConfig& config, const std::wstring& launcherName)
                     int msgboxID = MessageBox(NULL, L"This mod requires DXVK, but the d3d9.dll file is missing. While you can still proceed to launch this mod, you will crash in large scenarios, and experience a loss in performance. Would you like to acquire DXVK?", L"Warning", MB_YESNO | MB_ICONWARNING | MB_SETFOREGROUND | MB_TOPMOST);
                     if (msgboxID == IDYES)
                     {
-                        if (!CopyFileRaw(d3d9BinPath, L"d3d9.dll"))
+                        if (RestoreFileFromBaseline(d3d9BinPath, L"d3d9.dll") != RestoreResult::Restored)
                         {
                             std::wstringstream errorMessage;
                             errorMessage << L"Failed to create or replace the d3d9.dll file with the DXVK version. The " << d3d9BinPath << L" file may be missing. Reacquire it from the mod package, or try again.";
                             MessageBox(NULL, errorMessage.str().c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                             return false;
                         }
+                        InvalidateBinFileChecks(binFileChecks, L"d3d9.dll");
                         d3d9IsDXVK = true;
 
                         if (dxvkConfMissing)
@@ -1169,12 +1803,13 @@ bool VerifyDXVK(LaunchConfig& config, const std::wstring& launcherName)
                             dxvkConfFile << "dxgi.maxFrameRate = 60\n";
                             dxvkConfFile << "d3d9.maxFrameRate = 60\n";
                             dxvkConfFile.close();
+                            InvalidateDirectoryCache(L"dxvk.conf");
                         }
                     }
                     if (msgboxID == IDNO)
                     {
                         config.IgnoredWarnings.insert(warningKey);
-                        WriteLaunchConfig(config);
+                        MarkLaunchConfigDirty(L"IgnoredWarnings");
                     }
                 }
             }
@@ -1192,18 +1827,19 @@ bool VerifyDXVK(LaunchConfig& config, const std::wstring& launcherName)
                         int msgboxID = MessageBox(NULL, L"This mod requires DXVK, but the present d3d9.dll file is not identified as DXVK. While you can still proceed to launch this mod, you will crash in large scenarios, and experience a loss in performance. Would you like to replace it with the DXVK version?", L"Warning", MB_YESNO | MB_ICONWARNING | MB_SETFOREGROUND | MB_TOPMOST);
                         if (msgboxID == IDYES)
                         {
-                            if (!CopyFileRaw(d3d9BinPath, L"d3d9.dll"))
+                            if (RestoreFileFromBaseline(d3d9BinPath, L"d3d9.dll") != RestoreResult::Restored)
                             {
                                 std::wstringstream errorMessage;
                                 errorMessage << L"Failed to create or replace the d3d9.dll file with the DXVK version. The " << d3d9BinPath << L" file may be missing. Reacquire it from the mod package, or try again.";
                                 MessageBox(NULL, errorMessage.str().c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                                 return false;
                             }
+                            InvalidateBinFileChecks(binFileChecks, L"d3d9.dll");
                         }
                         if (msgboxID == IDNO)
                         {
                             config.IgnoredWarnings.insert(warningKey);
-                            WriteLaunchConfig(config);
+                            MarkLaunchConfigDirty(L"IgnoredWarnings");
                         }
                     }
                 }
@@ -1225,6 +1861,7 @@ bool VerifyDXVK(LaunchConfig& config, const std::wstring& launcherName)
                 dxvkConfFile << "dxgi.maxFrameRate = 60\n";
                 dxvkConfFile << "d3d9.maxFrameRate = 60\n";
                 dxvkConfFile.close();
+                InvalidateDirectoryCache(L"dxvk.conf");
             }
         }
     }
@@ -1237,29 +1874,30 @@ bool VerifyDXVK(LaunchConfig& config, const std::wstring& launcherName)
             struct FileCheck
             {
                 std::wstring fileName;
-                std::wstring binFileName;
+                std::wstring baseFileName;
             };
 
             FileCheck filesToCheck[] =
             {
-                {L"DivxDecoder.dll", L"DivxDecoder.bin"},
-                {L"DivxMediaLib.dll", L"DivxMediaLib.bin"}
+                {L"DivxDecoder.dll", L"DivxDecoder"},
+                {L"DivxMediaLib.dll", L"DivxMediaLib"}
             };
 
             for (const auto& file : filesToCheck)
             {
                 std::wstring filePath = file.fileName;
-                std::wstring binFilePath = config.BinFolder + L"\\" + launcherName + L"_" + file.binFileName;
-                std::string currentMD5, expectedMD5;
-                if (GetFileAttributes(filePath.c_str()) != INVALID_FILE_ATTRIBUTES)
+                std::wstring binFilePath = GetBinFilePath(config, launcherName, file.baseFileName);
+                if (PathExists(filePath))
                 {
-                    // calculate the expected MD5 checksum from the .bin file
-                    if (CalculateMD5(binFilePath.c_str(), expectedMD5))
+                    FilePairCheck check = TakeBinFileCheck(binFileChecks, filePath, binFilePath);
+
+                    // check the expected MD5 checksum from the .bin file
+                    if (check.baselineReadable)
                     {
-                        // calculate the current MD5 checksum from the .dll file
-                        if (CalculateMD5(filePath.c_str(), currentMD5) && currentMD5 != expectedMD5)
+                        // compare the current .dll file against the .bin file
+                        if (check.fileReadable && !check.filesMatch)
                         {
-                            if (!CopyFileRaw(binFilePath.c_str(), file.fileName.c_str()))
+                            if (RestoreFileFromBaseline(binFilePath, file.fileName) != RestoreResult::Restored)
                             {
                                 std::wstringstream errorMessage;
                                 errorMessage << L"Failed to create or replace the " << file.fileName << L" file with the correct version that is required in order to allow movies to play correctly with the DXVK and injector combination. The " << binFilePath << L" file may be missing. Reacquire it from the mod package, or try again.";
@@ -1296,14 +1934,15 @@ bool VerifyDXVK(LaunchConfig& config, const std::wstring& launcherName)
                     {
                         DeleteFile(L"d3d9.dll");
                         DeleteFile(L"dxvk.conf");
+                        InvalidateDirectoryCache(L"d3d9.dll");
 
-                        if (GetFileAttributes(L"d3d9.dll") != INVALID_FILE_ATTRIBUTES)
+                        if (PathExists(L"d3d9.dll"))
                         {
                             MessageBox(NULL, L"Failed to delete the DXVK d3d9.dll file. Remove it manually, or try again.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                             return false;
                         }
 
-                        if (GetFileAttributes(L"dxvk.conf") != INVALID_FILE_ATTRIBUTES)
+                        if (PathExists(L"dxvk.conf"))
                         {
                             MessageBox(NULL, L"Failed to delete the DXVK dxvk.conf file. Remove it manually, or try again.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                             return false;
@@ -1312,7 +1951,7 @@ bool VerifyDXVK(LaunchConfig& config, const std::wstring& launcherName)
                     if (msgboxID == IDNO)
                     {
                         config.IgnoredWarnings.insert(warningKey);
-                        WriteLaunchConfig(config);
+                        MarkLaunchConfigDirty(L"IgnoredWarnings");
                     }
                 }
             }
@@ -1321,6 +1960,236 @@ bool VerifyDXVK(LaunchConfig& config, const std::wstring& launcherName)
     return true;
 }
 
+#ifdef LAUNCHER_BENCHMARK
+// function to run the UCS check over every locale file of a tree, as ValidateUCSFiles does but without reporting, false if any file is malformed
+bool ProcessBenchmarkUCSFiles(const std::vector<std::wstring>& ucsFiles)
+{
+    std::vector<UCSFileResult> results(ucsFiles.size());
+    ParallelFor(ucsFiles.size(), [&ucsFiles, &results](size_t index)
+        {
+            ProcessUCSFile(ucsFiles[index], results[index]);
+        });
+
+    for (const auto& result : results)
+    {
+        if (!result.errors.empty())
+        {
+            std::wcerr << result.errors.front() << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// function to load generated text files for the line break kernels, decoded as CheckAndConvertToWindowsCRLF decodes them
+bool LoadBenchmarkTexts(const std::vector<std::wstring>& filePaths, BenchmarkTexts& texts)
+{
+    for (const auto& filePath : filePaths)
+    {
+        std::string rawContent;
+        if (!ReadWholeFile(filePath, rawContent))
+        {
+            return false;
+        }
+
+        TextEncoding encoding = DetectTextEncoding(rawContent);
+        if (encoding == TextEncoding::UTF16LE || encoding == TextEncoding::UTF16BE)
+        {
+            texts.utf16.emplace_back();
+            DecodeToUTF16(rawContent, encoding, texts.utf16.back());
+        }
+        else
+        {
+            texts.utf8.push_back(rawContent.substr(encoding == TextEncoding::UTF8BOM ? 3 : 0));
+        }
+        texts.bytes += rawContent.size();
+    }
+    return true;
+}
+
+// function to run the line break check over generated text files, converting those that are not in CRLF format in place
+bool CheckBenchmarkTextFiles(const std::vector<std::wstring>& filePaths)
+{
+    std::u16string content;
+    for (const auto& filePath : filePaths)
+    {
+        if (!CheckAndConvertToWindowsCRLF(filePath, content))
+        {
+            std::wcerr << L"Failed to check the line breaks of " << filePath << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// function to generate a synthetic mod tree and measure the validation pipelines on it, first cold and then again with their caches warm
+// the tree is generated anew on every run, as the first UCS pass converts its files in place
+int RunBenchmarks(const std::wstring& directory, const BenchmarkOptions& options)
+{
+    BenchmarkFixture fixture;
+    std::cout << "Generating the benchmark mod tree in " << WStringToString(directory) << "..." << std::endl;
+    BenchmarkResult generation = MeasureBenchmark("Fixture generation", 0, 0, [&directory, &options, &fixture]()
+        {
+            return GenerateBenchmarkFixture(directory, options, fixture);
+        });
+    if (!generation.succeeded)
+    {
+        std::cerr << "Failed to generate the benchmark mod tree. The directory must be empty, or hold a tree generated by an earlier benchmark." << std::endl;
+        return 1;
+    }
+
+    // the checks resolve the mod's files relative to the working directory, as they do when the launcher runs next to the game
+    boost::system::error_code ec;
+    boost::filesystem::current_path(boost::filesystem::path(fixture.rootDir), ec);
+    if (ec)
+    {
+        std::cerr << "Failed to enter the benchmark mod tree." << std::endl;
+        return 1;
+    }
+
+    // the checks report their errors in message boxes, which would stop an unattended run, so they are captured and printed with the results
+    CaptureErrors(true);
+    std::vector<BenchmarkResult> results;
+    results.push_back(generation);
+
+    LaunchConfig config;
+    results.push_back(MeasureBenchmark("ReadLaunchConfig", fixture.configBytes * BENCHMARK_CONFIG_READS, BENCHMARK_CONFIG_READS, [&fixture, &config]()
+        {
+            for (int i = 0; i < BENCHMARK_CONFIG_READS; ++i)
+            {
+                if (!ReadLaunchConfig(fixture.configFilePath, config))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }));
+
+    // the line break kernels are compared in memory on the UCS and .module texts, before the line break check converts the copies they are loaded from
+    std::vector<std::wstring> textFiles(fixture.ucsCopies);
+    textFiles.insert(textFiles.end(), fixture.moduleCopies.begin(), fixture.moduleCopies.end());
+    BenchmarkTexts texts;
+    if (!LoadBenchmarkTexts(textFiles, texts))
+    {
+        std::cerr << "Failed to load the generated text files." << std::endl;
+        return 1;
+    }
+
+    size_t scalarLineBreaks = 0;
+    results.push_back(MeasureBenchmark("FindLineBreakScalar", texts.bytes, textFiles.size(), [&texts, &scalarLineBreaks]()
+        {
+            scalarLineBreaks = CountBenchmarkLineBreaks(texts, true);
+            return scalarLineBreaks > 0;
+        }));
+    results.push_back(MeasureBenchmark("FindLineBreak", texts.bytes, textFiles.size(), [&texts, &scalarLineBreaks]()
+        {
+            return CountBenchmarkLineBreaks(texts, false) == scalarLineBreaks;
+        }));
+
+    size_t appendedLength = 0;
+    results.push_back(MeasureBenchmark("CRLF conversion (appending loop)", texts.bytes, textFiles.size(), [&texts, &appendedLength]()
+        {
+            appendedLength = ConvertBenchmarkTexts(texts, true);
+            return appendedLength > 0;
+        }));
+    results.push_back(MeasureBenchmark("ConvertToCRLF", texts.bytes, textFiles.size(), [&texts, &appendedLength]()
+        {
+            return ConvertBenchmarkTexts(texts, false) == appendedLength;
+        }));
+    texts = BenchmarkTexts();
+
+    // the first pass converts the copies with bare line breaks, keeping their encoding, the second only scans them
+    results.push_back(MeasureBenchmark("CheckAndConvertToWindowsCRLF (UCS, convert)", fixture.ucsBytes, fixture.ucsCopies.size(), [&fixture]()
+        {
+            return CheckBenchmarkTextFiles(fixture.ucsCopies);
+        }));
+
+    unsigned long long convertedCopyBytes = 0;
+    for (const auto& ucsCopy : fixture.ucsCopies)
+    {
+        convertedCopyBytes += boost::filesystem::file_size(boost::filesystem::path(ucsCopy), ec);
+    }
+    results.push_back(MeasureBenchmark("CheckAndConvertToWindowsCRLF (UCS, in place)", convertedCopyBytes, fixture.ucsCopies.size(), [&fixture]()
+        {
+            return CheckBenchmarkTextFiles(fixture.ucsCopies);
+        }));
+
+    results.push_back(MeasureBenchmark("CheckAndConvertToWindowsCRLF (.module)", fixture.moduleCopyBytes * BENCHMARK_MODULE_CHECKS, fixture.moduleCopies.size() * BENCHMARK_MODULE_CHECKS, [&fixture]()
+        {
+            for (int i = 0; i < BENCHMARK_MODULE_CHECKS; ++i)
+            {
+                if (!CheckBenchmarkTextFiles(fixture.moduleCopies))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }));
+
+    // the first pass converts every file that is not already UTF-16 LE with CRLF line breaks, the second validates them all in place
+    std::vector<std::wstring> ucsFiles;
+    CollectUCSFiles(fixture.rootDir + L"\\GameAssets\\Locale", ucsFiles);
+    results.push_back(MeasureBenchmark("ProcessUCSFile (convert)", fixture.ucsBytes, ucsFiles.size(), [&ucsFiles]()
+        {
+            return ProcessBenchmarkUCSFiles(ucsFiles);
+        }));
+
+    unsigned long long convertedUcsBytes = 0;
+    for (const auto& ucsFile : ucsFiles)
+    {
+        convertedUcsBytes += boost::filesystem::file_size(boost::filesystem::path(ucsFile), ec);
+    }
+    results.push_back(MeasureBenchmark("ProcessUCSFile (in place)", convertedUcsBytes, ucsFiles.size(), [&ucsFiles]()
+        {
+            return ProcessBenchmarkUCSFiles(ucsFiles);
+        }));
+
+    // the archive manifest and hash cache are never loaded from disk here, so resetting them only clears what the previous run stored
+    ResetArchiveManifest();
+    results.push_back(MeasureBenchmark("CheckModuleFile (header)", 0, fixture.archives, [&fixture, &config]()
+        {
+            return CheckModuleFile(fixture.rootDir, fixture.moduleFileName, config, fixture.modName, SgaVerificationLevel::Header);
+        }));
+
+    ResetArchiveManifest();
+    results.push_back(MeasureBenchmark("CheckModuleFile (full)", fixture.archiveBytes, fixture.archives, [&fixture, &config]()
+        {
+            return CheckModuleFile(fixture.rootDir, fixture.moduleFileName, config, fixture.modName, SgaVerificationLevel::Full);
+        }));
+
+    results.push_back(MeasureBenchmark("CheckModuleFile (full, verified)", 0, fixture.archives, [&fixture, &config]()
+        {
+            return CheckModuleFile(fixture.rootDir, fixture.moduleFileName, config, fixture.modName, SgaVerificationLevel::Full);
+        }));
+
+    ResetHashCache();
+    auto checkAdditionalFiles = [&fixture, &config]()
+        {
+            std::vector<FilePairCheck> binFileChecks = CollectBinFileChecks(config, fixture.modName, false);
+            CompareFilePairsParallel(binFileChecks);
+            return CheckAdditionalFiles(config, fixture.modName, binFileChecks);
+        };
+    results.push_back(MeasureBenchmark("CheckAdditionalFiles (hashed)", fixture.additionalBytes, config.AdditionalFiles.size() * 2, checkAdditionalFiles));
+    results.push_back(MeasureBenchmark("CheckAdditionalFiles (cached)", 0, config.AdditionalFiles.size() * 2, checkAdditionalFiles));
+
+    std::vector<std::wstring> errors = CaptureErrors(false);
+
+    std::cout << std::endl;
+    PrintBenchmarkHeader();
+    bool succeeded = true;
+    for (const auto& result : results)
+    {
+        PrintBenchmarkResult(result);
+        succeeded = succeeded && result.succeeded;
+    }
+    for (const auto& error : errors)
+    {
+        std::wcerr << L"Error: " << error << std::endl;
+    }
+    return succeeded ? 0 : 1;
+}
+#endif
+
 // main function
 int main(int argc, char* argv[])
 {
@@ -1328,6 +2197,13 @@ int main(int argc, char* argv[])
     bool resetConfig = false;
     bool noLaunch = false;
     bool linuxUnsafeMode = false;
+    bool verifyArchives = false;
+    bool selfTest = false;
+    std::wstring selfTestFixtures;
+#ifdef LAUNCHER_BENCHMARK
+    std::wstring benchmarkDirectory;
+    BenchmarkOptions benchmarkOptions;
+#endif
 
     // parse command-line arguments
     for (int i = 1; i < argc; ++i)
@@ -1349,11 +2225,52 @@ int main(int argc, char* argv[])
         {
             linuxUnsafeMode = true;
         }
+        else if (arg == "-verifyarchives")
+        {
+            verifyArchives = true;
+        }
+        else if (arg == "-trace" && i + 1 < argc)
+        {
+            StartTrace(argv[++i]);
+        }
+        else if (arg == "-selftest")
+        {
+            selfTest = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+            {
+                selfTestFixtures = StringToWString(argv[++i]);
+            }
+        }
+#ifdef LAUNCHER_BENCHMARK
+        else if (arg == "-benchmark" && i + 1 < argc)
+        {
+            benchmarkDirectory = StringToWString(argv[++i]);
+        }
+        else if (arg == "-benchmarksize" && i + 1 < argc)
+        {
+            benchmarkOptions.archiveSize = std::strtoull(argv[++i], nullptr, 10) * 1024ULL * 1024ULL;
+        }
+#endif
+    }
+
+    // -selftest checks the portable modules against known results instead of launching the game
+    if (selfTest)
+    {
+        return RunSelfTests(selfTestFixtures.empty() ? SELFTEST_FIXTURES_DIRECTORY : selfTestFixtures, !selfTestFixtures.empty());
     }
 
-    std::string process_name = get_current_process_name();
+#ifdef LAUNCHER_BENCHMARK
+    // -benchmark measures the checks on a generated mod tree instead of launching the game, only in the Benchmark configuration
+    if (!benchmarkDirectory.empty())
+    {
+        return RunBenchmarks(benchmarkDirectory, benchmarkOptions);
+    }
+#endif
 
-    if (is_process_running(process_name)) 
+    // only one launcher of the same name may run at a time, the guard holds the lock until the launcher exits
+    SingleInstanceGuard instanceGuard(get_current_process_name());
+
+    if (!instanceGuard.acquired) 
     {
         std::cerr << "Another instance of the launcher is already running. Wait for it to close, or manually terminate it before attempting to launch again." << std::endl;
         std::cerr << "Press [Enter] to exit..." << std::endl;
@@ -1416,18 +2333,38 @@ int main(int argc, char* argv[])
         std::wstring rootDir = std::wstring(launcherPath).substr(0, std::wstring(launcherPath).find_last_of(L"\\/"));
 
         // read launch parameters from the .launchconfig file
-        LaunchConfig config = ReadLaunchConfig();
+        LaunchConfig config;
+        if (!ReadLaunchConfig(GetLaunchConfigFilePath(), config))
+        {
+            return 1;
+        }
+
+        // changes to the launch configuration are written once, at the end of the checks or when the launcher returns early
+        LaunchConfigFlushGuard configFlushGuard(config);
+
+        // load the checksums cached by previous launches, stored next to the .launchconfig file
+        std::wstring hashCacheFilePath = launcherPath;
+        hashCacheFilePath = hashCacheFilePath.substr(0, hashCacheFilePath.find_last_of(L".")) + L".hashcache";
+        LoadHashCache(hashCacheFilePath);
+
+        // load the archives verified by previous launches, stored next to the .launchconfig file
+        std::wstring archiveManifestFilePath = launcherPath;
+        archiveManifestFilePath = archiveManifestFilePath.substr(0, archiveManifestFilePath.find_last_of(L".")) + L".archivemanifest";
+        LoadArchiveManifest(archiveManifestFilePath);
 
         if (resetConfig)
         {
             config.FirstTimeLaunchCheck = true;
             config.IgnoredWarnings.clear();
-            WriteLaunchConfig(config);
+            MarkLaunchConfigDirty(L"FirstTimeLaunchCheck");
+            MarkLaunchConfigDirty(L"IgnoredWarnings");
+            ResetHashCache();
+            ResetArchiveManifest();
         }
 
         // display the gif if no bitmap found
         std::thread gifThread;
-        if (GetFileAttributes(gifFileName.c_str()) != INVALID_FILE_ATTRIBUTES && GetFileAttributes(bitmapFileName.c_str()) == INVALID_FILE_ATTRIBUTES)
+        if (PathExists(gifFileName) && !PathExists(bitmapFileName))
         {
             InitializeGDIPlus();
             gifThread = std::thread(GifThread, hInstance, gifFileName);
@@ -1435,13 +2372,13 @@ int main(int argc, char* argv[])
 
         // display the bitmap if no gif found
         std::thread bitmapThread;
-        if (GetFileAttributes(gifFileName.c_str()) == INVALID_FILE_ATTRIBUTES && GetFileAttributes(bitmapFileName.c_str()) != INVALID_FILE_ATTRIBUTES)
+        if (!PathExists(gifFileName) && PathExists(bitmapFileName))
         {
             bitmapThread = std::thread(BitmapThread, hInstance, bitmapFileName);
         }
 
         // prioritize gif if both found
-        if (GetFileAttributes(gifFileName.c_str()) != INVALID_FILE_ATTRIBUTES && GetFileAttributes(bitmapFileName.c_str()) != INVALID_FILE_ATTRIBUTES)
+        if (PathExists(gifFileName) && PathExists(bitmapFileName))
         {
             InitializeGDIPlus();
             gifThread = std::thread(GifThread, hInstance, gifFileName);
@@ -1458,7 +2395,7 @@ int main(int argc, char* argv[])
         }
 
         // check for console and bitmap
-        if (GetFileAttributes(bitmapFileName.c_str()) == INVALID_FILE_ATTRIBUTES && GetFileAttributes(bitmapFileName.c_str()) == INVALID_FILE_ATTRIBUTES || config.Console)
+        if (!PathExists(bitmapFileName) && !PathExists(bitmapFileName) || config.Console)
         {
             // show the console window if the bitmap file does not exist or if console is true
             HWND consoleWnd = GetConsoleWindow();
@@ -1497,6 +2434,12 @@ int main(int argc, char* argv[])
 
         CONSOLE_MESSAGE(L"Launcher initialized.");
 
+        TracePhase("Launcher initialization");
+
+        // probe the processor topology once, it decides which game files are needed and which cores the game runs on
+        CpuTopology cpuTopology;
+        bool cpuTopologyProbed = ProbeCpuTopology(cpuTopology);
+
         // START CHECKS
         if (!config.IsUnsafe)
         {
@@ -1509,7 +2452,7 @@ int main(int argc, char* argv[])
                 }
 
                 config.FirstTimeLaunchCheck = false;
-                WriteLaunchConfig(config);
+                MarkLaunchConfigDirty(L"FirstTimeLaunchCheck");
             }
 
             if (config.VerboseDebug)
@@ -1517,6 +2460,8 @@ int main(int argc, char* argv[])
                 MessageBox(NULL, L"Verified first time launch.", L"Debug", MB_OK | MB_ICONINFORMATION | MB_SETFOREGROUND | MB_TOPMOST);
             }
 
+            TracePhase("First time launch check");
+
             // check if DOW2.exe is already running
             if (IsProcessRunning(APP_NAME))
             {
@@ -1548,8 +2493,10 @@ int main(int argc, char* argv[])
                 MessageBox(NULL, L"Verified DOW2.exe running state.", L"Debug", MB_OK | MB_ICONINFORMATION | MB_SETFOREGROUND | MB_TOPMOST);
             }
 
+            TracePhase("Running game check");
+
             // check if DOW2.exe exists in the same directory as the launcher
-            if (GetFileAttributes(APP_NAME) == INVALID_FILE_ATTRIBUTES)
+            if (!PathExists(APP_NAME))
             {
                 MessageBox(NULL, L"Failed to find DOW2.exe. You have installed the mod into the wrong directory, or your game is missing or corrupt. Install the mod into the correct directory, or try again.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                 return 1;
@@ -1562,34 +2509,38 @@ int main(int argc, char* argv[])
 
             CONSOLE_MESSAGE(L"DOW2 check.");
 
+            TracePhase("DOW2 check");
+
             // check for ChaosRisingGDF.dll if IsRetribution is true
-            if (config.IsRetribution && GetFileAttributes(L"ChaosRisingGDF.dll") != INVALID_FILE_ATTRIBUTES)
+            if (config.IsRetribution && PathExists(L"ChaosRisingGDF.dll"))
             {
                 MessageBox(NULL, L"Found ChaosRisingGDF.dll; this may be Dawn of War II - Chaos Rising, but this version of the mod is designed for Dawn of War II - Retribution. Install the mod to Dawn of War II - Retribution.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                 return 1;
             }
 
             // check for CGalaxy.dll if IsSteam is true
-            if (config.IsSteam && GetFileAttributes(L"CGalaxy.dll") != INVALID_FILE_ATTRIBUTES)
+            if (config.IsSteam && PathExists(L"CGalaxy.dll"))
             {
                 MessageBox(NULL, L"Found CGalaxy.dll; this may be a GOG distribution of the game, but this version of the mod is designed for the Steam distribution of the game. Install the mod to the Steam version of the game.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                 return 1;
             }
 
             // check for ChaosRisingGDF.dll if IsRetribution is false
-            if (!config.IsRetribution && GetFileAttributes(L"ChaosRisingGDF.dll") == INVALID_FILE_ATTRIBUTES)
+            if (!config.IsRetribution && !PathExists(L"ChaosRisingGDF.dll"))
             {
                 MessageBox(NULL, L"The ChaosRisingGDF.dll file is missing, but this version of the mod is designed for Dawn of War II - Chaos Rising. Install the mod to Dawn of War II - Chaos Rising.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                 return 1;
             }
 
             // check for CGalaxy.dll if IsSteam is false
-            if (!config.IsSteam && GetFileAttributes(L"CGalaxy.dll") == INVALID_FILE_ATTRIBUTES)
+            if (!config.IsSteam && !PathExists(L"CGalaxy.dll"))
             {
                 MessageBox(NULL, L"The CGalaxy.dll file is missing, but this version of the mod is designed for the GOG distribution of the game. Install the mod to the GOG distribution of the game.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                 return 1;
             }
 
+            TracePhase("Game distribution check");
+
             // check GameVersion field entry against DOW2.exe file version
             if (!config.GameVersion.empty())
             {
@@ -1610,11 +2561,18 @@ int main(int argc, char* argv[])
 
             CONSOLE_MESSAGE(L"Version check.");
 
-            int numCores = GetProcessorCoreCount();
+            TracePhase("Version check");
+
+            // the updated XThread.dll is needed once the game sees twelve or more logical processors, counted across every processor group
+            bool verifyXThread = cpuTopology.logicalProcessors >= 12 && config.IsSteam && !config.Injector;
 
-            if (numCores >= 12 && config.IsSteam && !config.Injector)
+            // compare every .bin-backed file with its baseline up front on worker threads, the checks below then only restore
+            std::vector<FilePairCheck> binFileChecks = CollectBinFileChecks(config, baseLauncherName, verifyXThread);
+            CompareFilePairsParallel(binFileChecks);
+
+            if (verifyXThread)
             {
-               if (!VerifyXThread(config, baseLauncherName))
+               if (!VerifyXThread(config, baseLauncherName, binFileChecks))
                {
                    return 1;
                }
@@ -1630,6 +2588,8 @@ int main(int argc, char* argv[])
                 CONSOLE_MESSAGE(L"CPU check.");
             }
 
+            TracePhase("CPU check");
+
             // check for a vulkan-capable GPU if DXVK is true
             if (config.IsDXVK && !HasVulkanSupport())
             {
@@ -1649,8 +2609,10 @@ int main(int argc, char* argv[])
                 CONSOLE_MESSAGE(L"Vulkan check.");
             }
 
+            TracePhase("Vulkan check");
+
             // check for dxvk
-            if (!VerifyDXVK(config, baseLauncherName))
+            if (!VerifyDXVK(config, baseLauncherName, binFileChecks))
             {
                return 1;
             }
@@ -1665,6 +2627,8 @@ int main(int argc, char* argv[])
                 CONSOLE_MESSAGE(L"DXVK check.");
             }
 
+            TracePhase("DXVK check");
+
             // check for large address aware
             if (config.LAAPatch && Is32BitApplication(APP_NAME))
             {
@@ -1687,7 +2651,7 @@ int main(int argc, char* argv[])
                             if (msgboxID == IDNO)
                             {
                                 config.IgnoredWarnings.insert(warningKey);
-                                WriteLaunchConfig(config);
+                                MarkLaunchConfigDirty(L"IgnoredWarnings");
                             }
                         }
                     }
@@ -1714,7 +2678,7 @@ int main(int argc, char* argv[])
                             if (msgboxID == IDNO)
                             {
                                 config.IgnoredWarnings.insert(warningKey);
-                                WriteLaunchConfig(config);
+                                MarkLaunchConfigDirty(L"IgnoredWarnings");
                             }
                         }
                     }
@@ -1731,6 +2695,8 @@ int main(int argc, char* argv[])
                 CONSOLE_MESSAGE(L"Large address aware check.");
             }
 
+            TracePhase("Large address aware check");
+
             // check for the compatibility mode
             if (config.WIN7CompatibilityMode)
             {
@@ -1755,7 +2721,7 @@ int main(int argc, char* argv[])
                                 if (msgboxID == IDNO)
                                 {
                                     config.IgnoredWarnings.insert(warningKey);
-                                    WriteLaunchConfig(config);
+                                    MarkLaunchConfigDirty(L"IgnoredWarnings");
                                 }
                             }
                         }
@@ -1785,7 +2751,7 @@ int main(int argc, char* argv[])
                                 if (msgboxID == IDNO)
                                 {
                                     config.IgnoredWarnings.insert(warningKey);
-                                    WriteLaunchConfig(config);
+                                    MarkLaunchConfigDirty(L"IgnoredWarnings");
                                 }
                             }
                         }
@@ -1800,6 +2766,8 @@ int main(int argc, char* argv[])
 
             CONSOLE_MESSAGE(L"Compatibility check.");
 
+            TracePhase("Compatibility check");
+
             // check game settings for UI incompatibilities, errors are handled in the function
             if (config.UIWarnings)
             {
@@ -1816,11 +2784,13 @@ int main(int argc, char* argv[])
                 CONSOLE_MESSAGE(L"Game configuration check.");
             }
 
+            TracePhase("Game configuration check");
+
             // check for injector
             if (config.Injector)
             {
                 // check if the .config file exists in the same directory
-                if (GetFileAttributes(configFileName.c_str()) == INVALID_FILE_ATTRIBUTES)
+                if (!PathExists(configFileName))
                 {
                     MessageBox(NULL, (L"Failed to find the mod's " + configFileName + L" injector config file. Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                     return 1;
@@ -1841,17 +2811,18 @@ int main(int argc, char* argv[])
                     return 1; // error message is handled in InjectedConfigurationsPresent
                 }
 
-                if (GetFileAttributes(config.InjectorFileName.c_str()) == INVALID_FILE_ATTRIBUTES)
+                if (!PathExists(config.InjectorFileName))
                 {
-                    std::wstring binFileName = config.BinFolder + L"\\" + baseLauncherName + L"_" + config.InjectorFileName.substr(0, config.InjectorFileName.find_last_of(L".")) + L".bin";
-                    if (!CopyFileRaw(binFileName.c_str(), config.InjectorFileName.c_str()))
+                    std::wstring binFileName = GetInjectorBinFilePath(config, baseLauncherName);
+                    if (RestoreFileFromBaseline(binFileName, config.InjectorFileName) != RestoreResult::Restored)
                     {
                         MessageBox(NULL, (L"Failed to create or replace the injector file required by this mod. The " + binFileName + L" file may be missing. Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                         return 1;
                     }
+                    InvalidateBinFileChecks(binFileChecks, config.InjectorFileName);
                 }
                 
-                if (!InjectorBinaryProcessing(config, baseLauncherName))
+                if (!InjectorBinaryProcessing(config, baseLauncherName, binFileChecks))
                 {
                     return 1;
                 }
@@ -1867,7 +2838,9 @@ int main(int argc, char* argv[])
                 CONSOLE_MESSAGE(L"Injector check.");
             }
 
-            if (!CheckAdditionalFiles(config, baseLauncherName))
+            TracePhase("Injector check");
+
+            if (!CheckAdditionalFiles(config, baseLauncherName, binFileChecks))
             {
                 return 1;
             }
@@ -1877,14 +2850,18 @@ int main(int argc, char* argv[])
                 MessageBox(NULL, L"Verified additional files.", L"Debug", MB_OK | MB_ICONINFORMATION | MB_SETFOREGROUND | MB_TOPMOST);
             }
 
+            TracePhase("Additional files check");
+
             // check if the .module file exists in the same directory
-            if (GetFileAttributes(moduleFileName.c_str()) == INVALID_FILE_ATTRIBUTES)
+            if (!PathExists(moduleFileName))
             {
                 MessageBox(NULL, (L"Failed to find this mod's " + moduleFileName + L" module file. Reacquire it from the mod package, or try again.").c_str(), L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
                 return 1;
             }
 
-            if (!CheckModuleFile(moduleFileName, config, baseLauncherName))
+            // -verifyarchives requests full verification for this run without changing the launch configuration
+            SgaVerificationLevel archiveVerification = verifyArchives ? SgaVerificationLevel::Full : config.ArchiveVerification;
+            if (!CheckModuleFile(rootDir, moduleFileName, config, baseLauncherName, archiveVerification))
             {
                 return 1;
             }
@@ -1896,8 +2873,10 @@ int main(int argc, char* argv[])
 
             CONSOLE_MESSAGE(L"Module check.");
 
+            TracePhase("Module check");
+
             // call the UCS file validation function
-            if (!ValidateUCSFiles(rootDir))
+            if (!ValidateUCSFiles(rootDir, config))
             {
                 return 1;
             }
@@ -1915,8 +2894,17 @@ int main(int argc, char* argv[])
             }
 
             CONSOLE_MESSAGE(L"ALL CHECKS COMPLETE.");
+
+            TracePhase("UCS check");
+
+            // persist the checksums calculated during the checks, a failure only costs a full hash on the next launch
+            SaveHashCache();
+            SaveArchiveManifest();
+            FlushLaunchConfig(config);
         }
 
+        TracePhase("Cache persistence");
+
         // END CHECKS
         // launch the game
         if (noLaunch)
@@ -1933,111 +2921,136 @@ int main(int argc, char* argv[])
 
         STARTUPINFO si = { sizeof(si) };
         PROCESS_INFORMATION pi;
+        GameLaunchPolicy launchPolicy;
+        DWORD readyPriorityClass = launchPolicy.priorityClass; // 0 once the priority class could not be applied, so the readiness wait does not require it
+        bool ioPriorityApplied = false;
 
-        if (!CreateProcess(NULL, &commandLine[0], NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi))
+        // the game starts suspended so the launch policy is in place before it runs
+        DWORD creationFlags = config.IsUnsafe ? 0 : CREATE_SUSPENDED;
+        if (!CreateProcess(NULL, &commandLine[0], NULL, NULL, FALSE, creationFlags, NULL, NULL, &si, &pi))
         {
             MessageBox(NULL, L"Failed to find or open DOW2.exe. You have installed the mod into the wrong directory, or your game is missing or corrupt. Install the mod into the correct game directory, or try again.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
             return 1;
         }
 
-        CONSOLE_MESSAGE(L"DOW2.exe executed.");
-
-        bool dow2_running = false;
-
-        // loop until the program is found running
-        while (!dow2_running) 
+        if (!config.IsUnsafe)
         {
-            if (GetTickCount64() - startTime > TIMEOUT_PROCESS) // timeout check
+            // on processors with different core types the game is kept on the fastest cores of the processor group it was started in
+            USHORT processGroup = 0;
+            USHORT groupCount = 1;
+            if (cpuTopologyProbed && GetProcessGroupAffinity(pi.hProcess, &groupCount, &processGroup))
             {
-                MessageBox(NULL, L"Launcher process timed out before DOW2.exe was executed.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                return 1;
+                launchPolicy.affinityMask = static_cast<DWORD_PTR>(GetFastCoreAffinityMask(cpuTopology, processGroup));
+            }
+
+            if (!ApplyGameLaunchPolicy(pi.hProcess, launchPolicy, ioPriorityApplied))
+            {
+                CONSOLE_MESSAGE(L"Warning: failed to set the priority class of DOW2.exe.");
+                readyPriorityClass = 0;
             }
-            
-            dow2_running = IsProcessRunning(APP_NAME);
-            if (!dow2_running) 
+            else if (!ioPriorityApplied)
             {
-                Sleep(1000);
+                CONSOLE_MESSAGE(L"Warning: failed to set the I/O priority of DOW2.exe, the launcher lacks the privilege to increase scheduling priority.");
             }
+            ResumeThread(pi.hThread);
         }
 
-        if (dow2_running)
+        CONSOLE_MESSAGE(L"DOW2.exe executed.");
+
+        TracePhase("Game process creation");
+
+        // the launched process is running from here on, only its window has to be awaited
+        DWORD dow2ProcessId = pi.dwProcessId;
+        HWND mainWindowHandle = NULL;
+
+        if (!config.IsUnsafe)
         {
-            if (!config.IsUnsafe)
+            if (!WaitForGameWindow(pi.hProcess, pi.dwProcessId, APP_NAME, startTime + TIMEOUT_PROCESS, dow2ProcessId, mainWindowHandle))
             {
-                DWORD dow2ProcessId = 0;
-                HWND mainWindowHandle = NULL;
+                MessageBox(NULL, L"Launcher process timed out while waiting for the main window handle of DOW2.exe.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
+                return 1;
+            }
 
-                while (true)
+            // a game that relaunched itself runs in a process the launcher did not create, so the policy is applied to it now
+            if (dow2ProcessId != pi.dwProcessId)
+            {
+                HANDLE relaunchedProcess = OpenProcess(PROCESS_SET_INFORMATION | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, dow2ProcessId);
+                readyPriorityClass = 0;
+                if (relaunchedProcess != NULL)
                 {
-                    if (GetTickCount64() - startTime > TIMEOUT_PROCESS) // timeout check
-                    {
-                        MessageBox(NULL, L"Launcher process timed out while waiting for the main window handle of DOW2.exe.", L"Error", MB_OK | MB_ICONERROR | MB_SETFOREGROUND | MB_TOPMOST);
-                        return 1;
-                    }
-
-                    dow2ProcessId = FindProcessId(APP_NAME);
-                    mainWindowHandle = GetMainWindowHandle(dow2ProcessId);
-                    if (dow2ProcessId != 0 && mainWindowHandle != NULL)
+                    if (ApplyGameLaunchPolicy(relaunchedProcess, launchPolicy, ioPriorityApplied))
                     {
-                        break;
+                        readyPriorityClass = launchPolicy.priorityClass;
                     }
-                    Sleep(1000);
+                    CloseHandle(relaunchedProcess);
                 }
+                if (readyPriorityClass == 0)
+                {
+                    CONSOLE_MESSAGE(L"Warning: failed to set the priority class of the relaunched DOW2.exe.");
+                }
+            }
 
-                std::thread monitorThread(MonitorAndSetPriority);
-                monitorThread.detach();
-
-                std::string rawCommandLine = GetCommandLineOfProcess(dow2ProcessId);
-                std::string actualCommandLine = StripExecutablePath(rawCommandLine);
-                std::string expectedCommandLine = WStringToString(commandLine);
+            std::string rawCommandLine = GetCommandLineOfProcess(dow2ProcessId);
+            std::string actualCommandLine = StripExecutablePath(rawCommandLine);
+            std::string expectedCommandLine = WStringToString(commandLine);
 
-                // trim whitespace
-                actualCommandLine = TrimString(actualCommandLine);
-                expectedCommandLine = TrimString(expectedCommandLine);
+            // trim whitespace
+            actualCommandLine = TrimString(actualCommandLine);
+            expectedCommandLine = TrimString(expectedCommandLine);
 
-                // normalize command lines (convert to lowercase and remove extra spaces)
-                actualCommandLine = NormalizeCommandLine(actualCommandLine);
-                expectedCommandLine = NormalizeCommandLine(expectedCommandLine);
+            // normalize command lines (convert to lowercase and remove extra spaces)
+            actualCommandLine = NormalizeCommandLine(actualCommandLine);
+            expectedCommandLine = NormalizeCommandLine(expectedCommandLine);
 
-                // ensure both are trimmed again to remove any leading/trailing spaces
-                actualCommandLine = TrimString(actualCommandLine);
-                expectedCommandLine = TrimString(expectedCommandLine);
+            // ensure both are trimmed again to remove any leading/trailing spaces
+            actualCommandLine = TrimString(actualCommandLine);
+            expectedCommandLine = TrimString(expectedCommandLine);
 
-                // convert strings to wstrings for comparison and MessageBox
-                std::wstring actualCommandLineW = StringToWString(actualCommandLine);
-                std::wstring expectedCommandLineW = StringToWString(expectedCommandLine);
+            // convert strings to wstrings for comparison and MessageBox
+            std::wstring actualCommandLineW = StringToWString(actualCommandLine);
+            std::wstring expectedCommandLineW = StringToWString(expectedCommandLine);
 
-                if (actualCommandLineW != expectedCommandLineW)
+            if (!rawCommandLine.empty() && actualCommandLineW != expectedCommandLineW)
+            {
+                if (config.Warnings)
                 {
-                    if (config.Warnings)
-                    {
-                        SuspendProcess(dow2ProcessId);
-                        std::wstring warningMessage = L"DOW2.exe was launched with externally set launch parameters. If this is unintentional, make sure that you do not have extra launch parameters set through Steam, GOG, the runoptions.cfg file, or other means.\n\n";
-                        warningMessage += L"Expected Launch Parameters: " + expectedCommandLineW + L"\n";
-                        warningMessage += L"Actual Launch Parameters: " + actualCommandLineW;
-                        MessageBox(NULL, warningMessage.c_str(), L"Warning", MB_OK | MB_ICONWARNING | MB_SETFOREGROUND | MB_TOPMOST);
-                        ResumeProcess(dow2ProcessId);
-                        ForceFocusOnWindow(mainWindowHandle);
-                    }
+                    SuspendProcess(dow2ProcessId);
+                    std::wstring warningMessage = L"DOW2.exe was launched with externally set launch parameters. If this is unintentional, make sure that you do not have extra launch parameters set through Steam, GOG, the runoptions.cfg file, or other means.\n\n";
+                    warningMessage += L"Expected Launch Parameters: " + expectedCommandLineW + L"\n";
+                    warningMessage += L"Actual Launch Parameters: " + actualCommandLineW;
+                    MessageBox(NULL, warningMessage.c_str(), L"Warning", MB_OK | MB_ICONWARNING | MB_SETFOREGROUND | MB_TOPMOST);
+                    ResumeProcess(dow2ProcessId);
+                    ForceFocusOnWindow(mainWindowHandle);
                 }
             }
         }
 
-        // wait for a time before closing the launcher
-        Sleep(30000);
+        TracePhase("Game window and launch parameter check");
 
-        // destroy the bitmap window after waiting
-        if (bitmapThread.joinable()) 
+        // keep the launcher open until the game is ready, or at most for the configured idle cap
+        DWORD shutdownTimeout = static_cast<DWORD>(config.ShutdownTimeout) * 1000;
+        if (config.IsUnsafe)
+        {
+            WaitForInputIdle(pi.hProcess, shutdownTimeout);
+        }
+        else
         {
-            bitmapThread.join();
+            WaitForGameReady(dow2ProcessId, mainWindowHandle, readyPriorityClass, GetTickCount64() + shutdownTimeout);
         }
 
-        if (gifThread.joinable()) 
+        TracePhase("Game readiness wait");
+
+        // close the splash screen windows
+        bool gifShown = gifThread.joinable();
+        StopSplashThread(bitmapThread);
+        StopSplashThread(gifThread);
+        if (gifShown)
         {
-            gifThread.join();
             ShutdownGDIPlus();
         }
 
+        TracePhase("Splash screen shutdown");
+
         // close the process and thread handles
         CloseHandle(pi.hProcess);
         CloseHandle(pi.hThread);
@@ -0,0 +1,763 @@
+// header for the launcher's self-tests, run with -selftest, checking the portable modules against known results and captured fixtures
+
+#pragma once
+
+#define SELFTEST_FIXTURES_DIRECTORY L"tests" // directory of the captured fixtures, relative to the project directory the launcher is debugged from
+
+// standard library headers
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <chrono>
+
+// boost headers
+#include <boost/filesystem.hpp>
+
+// launcher headers
+#include "framework.h"
+
+// structure to hold the results of a self-test run
+struct SelfTestRun
+{
+    unsigned int passed = 0;
+    unsigned int failed = 0;
+};
+
+// function to record the outcome of one self-test check, printing the checks that fail
+void ExpectSelfTest(SelfTestRun& run, bool condition, const std::string& description)
+{
+    if (condition)
+    {
+        run.passed++;
+    }
+    else
+    {
+        run.failed++;
+        std::cerr << "FAILED: " << description << std::endl;
+    }
+}
+
+// function to get a path in the temporary directory for a file written by a self-test
+std::wstring GetSelfTestFilePath(const std::string& name)
+{
+    return (boost::filesystem::temp_directory_path() / ("DOW2Launcher.selftest." + name)).wstring();
+}
+
+
+
+//
+//
+//
+// HASHING
+//
+//
+//
+
+
+
+// structure to hold an input and its expected digest
+struct HashTestVector
+{
+    const char* input;
+    const char* digest;
+};
+
+// MD5 test suite of RFC 1321, appendix A.5
+const HashTestVector MD5_TEST_VECTORS[] =
+{
+    { "", "d41d8cd98f00b204e9800998ecf8427e" },
+    { "a", "0cc175b9c0f1b6a831c399e269772661" },
+    { "abc", "900150983cd24fb0d6963f7d28e17f72" },
+    { "message digest", "f96b697d7cb7938d525a2f31aaf161d0" },
+    { "abcdefghijklmnopqrstuvwxyz", "c3fcd3d76192e4007dfb496cca67e13b" },
+    { "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", "d174ab98d277d9f5a5611c2c9f419d9f" },
+    { "12345678901234567890123456789012345678901234567890123456789012345678901234567890", "57edf4a22be3c955ac49da2e2107b67a" }
+};
+
+// XXH64 digests of the same inputs with seed 0, from the reference implementation, inputs of 32 bytes and more take the striped path
+const HashTestVector XXH64_TEST_VECTORS[] =
+{
+    { "", "ef46db3751d8e999" },
+    { "a", "d24ec4f1a98c6e5b" },
+    { "abc", "44bc2cf5ad770999" },
+    { "message digest", "066ed728fceeb3be" },
+    { "abcdefghijklmnopqrstuvwxyz", "cfe1f278fa89835c" },
+    { "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", "aaa46907d3047814" },
+    { "12345678901234567890123456789012345678901234567890123456789012345678901234567890", "e04a477f19ee145d" }
+};
+
+// function to hash a string one byte at a time, so every block and stripe boundary of the streaming hashers is crossed
+std::string CalculateBytewiseHash(const std::string& input, HashAlgorithm algorithm)
+{
+    StreamingHasher hasher;
+    HasherInit(hasher, algorithm);
+    for (char c : input)
+    {
+        HasherUpdate(hasher, reinterpret_cast<const unsigned char*>(&c), 1);
+    }
+    return HasherFinalHex(hasher);
+}
+
+// function to check both hash algorithms against their known vectors, in one piece, byte by byte and streamed from a file, and the CRC-32 used by archive verification
+void RunHashSelfTests(SelfTestRun& run)
+{
+    const HashTestVector* vectorSets[2] = { MD5_TEST_VECTORS, XXH64_TEST_VECTORS };
+    const size_t vectorCounts[2] = { sizeof(MD5_TEST_VECTORS) / sizeof(MD5_TEST_VECTORS[0]), sizeof(XXH64_TEST_VECTORS) / sizeof(XXH64_TEST_VECTORS[0]) };
+    const HashAlgorithm algorithms[2] = { HashAlgorithm::MD5, HashAlgorithm::XXH64 };
+    const char* algorithmNames[2] = { "MD5", "XXH64" };
+    for (size_t set = 0; set < 2; ++set)
+    {
+        for (size_t i = 0; i < vectorCounts[set]; ++i)
+        {
+            const HashTestVector& vector = vectorSets[set][i];
+            std::string input(vector.input);
+            ExpectSelfTest(run, CalculateBufferHash(input.data(), input.size(), algorithms[set]) == vector.digest, std::string(algorithmNames[set]) + " of \"" + input + "\"");
+            ExpectSelfTest(run, CalculateBytewiseHash(input, algorithms[set]) == vector.digest, std::string(algorithmNames[set]) + " of \"" + input + "\" hashed byte by byte");
+        }
+    }
+
+    XXH64Context seeded;
+    XXH64Init(seeded, 1);
+    XXH64Update(seeded, reinterpret_cast<const unsigned char*>("abc"), 3);
+    ExpectSelfTest(run, XXH64Final(seeded) == 0xbea9ca8199328908ULL, "XXH64 of \"abc\" with seed 1");
+
+    // a file larger than the read buffer is streamed in several reads, and has to hash as it does in memory
+    std::string content(HASH_READ_BUFFER_SIZE * 3 + 17, '\0');
+    for (size_t i = 0; i < content.size(); ++i)
+    {
+        content[i] = static_cast<char>((i * 131 + 7) ^ (i >> 11));
+    }
+    std::wstring filePath = GetSelfTestFilePath("hash");
+    bool written = WriteWholeFile(filePath, nullptr, 0, content.data(), content.size());
+    ExpectSelfTest(run, written, "writing the hash test file");
+    for (size_t set = 0; set < 2 && written; ++set)
+    {
+        std::string fileDigest;
+        ExpectSelfTest(run, CalculateFileHash(filePath.c_str(), algorithms[set], fileDigest) && fileDigest == CalculateBufferHash(content.data(), content.size(), algorithms[set]),
+            std::string(algorithmNames[set]) + " of a file streamed through the read buffer");
+    }
+    DeletePortableFile(filePath.c_str());
+
+    ExpectSelfTest(run, UpdateCRC32(0, "123456789", 9) == 0xcbf43926, "CRC-32 check value of \"123456789\"");
+
+    // the CRC-32 of a split buffer, combined, has to match the CRC-32 calculated in a single pass
+    uint32_t wholeCrc = UpdateCRC32(0, content.data(), content.size());
+    const size_t splits[] = { 0, 1, 4095, content.size() / 2, content.size() - 1, content.size() };
+    for (size_t split : splits)
+    {
+        uint32_t firstCrc = UpdateCRC32(0, content.data(), split);
+        uint32_t secondCrc = UpdateCRC32(0, content.data() + split, content.size() - split);
+        ExpectSelfTest(run, CombineCRC32(firstCrc, secondCrc, content.size() - split) == wholeCrc, "CombineCRC32 split at byte " + std::to_string(split));
+    }
+}
+
+
+
+//
+//
+//
+// TEXT SCAN
+//
+//
+//
+
+
+
+// function to convert every bare CR and LF to CRLF one code unit at a time, the reference the block-wise kernels are checked against
+template <typename CharType>
+std::basic_string<CharType> ConvertToCRLFReference(const std::basic_string<CharType>& text, size_t& bareBreaks)
+{
+    std::basic_string<CharType> convertedText;
+    bareBreaks = 0;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if (text[i] == CharType('\r') && i + 1 < text.size() && text[i + 1] == CharType('\n'))
+        {
+            convertedText += text[i];
+            convertedText += text[++i];
+        }
+        else if (text[i] == CharType('\r') || text[i] == CharType('\n'))
+        {
+            convertedText += CharType('\r');
+            convertedText += CharType('\n');
+            ++bareBreaks;
+        }
+        else
+        {
+            convertedText += text[i];
+        }
+    }
+    return convertedText;
+}
+
+// function to build texts with line breaks at every position around the first blocks, including a CRLF split across a block edge, lone CRs and a trailing CR
+template <typename CharType>
+std::vector<std::basic_string<CharType>> GetLineBreakTestTexts()
+{
+    const char* breaks[] = { "\r\n", "\r", "\n", "\n\r", "\r\r\n" };
+    std::vector<std::basic_string<CharType>> texts;
+    for (const char* lineBreak : breaks)
+    {
+        for (size_t position = 0; position <= 40; ++position)
+        {
+            std::string text = std::string(position, 'x') + lineBreak;
+            texts.emplace_back(text.begin(), text.end());
+            text += std::string(40 - position, 'y') + "\r";
+            texts.emplace_back(text.begin(), text.end());
+        }
+    }
+    return texts;
+}
+
+// function to check the block-wise line break kernels against the scalar search and the reference conversion, starting at every offset of every text
+template <typename CharType>
+void CheckLineBreakKernels(SelfTestRun& run, const std::string& encodingName)
+{
+    bool searchesMatch = true;
+    bool countsMatch = true;
+    bool conversionsMatch = true;
+    for (const auto& text : GetLineBreakTestTexts<CharType>())
+    {
+        const CharType* end = text.data() + text.size();
+        for (const CharType* begin = text.data(); begin <= end; ++begin)
+        {
+            searchesMatch = searchesMatch && FindLineBreak(begin, end) == FindLineBreakScalar(begin, end);
+        }
+
+        size_t bareBreaks = 0;
+        std::basic_string<CharType> expected = ConvertToCRLFReference(text, bareBreaks);
+        countsMatch = countsMatch && CountBareLineBreaks(text.data(), end) == bareBreaks;
+        conversionsMatch = conversionsMatch && ConvertToCRLF(text.data(), end, bareBreaks) == expected;
+    }
+    ExpectSelfTest(run, searchesMatch, "FindLineBreak finds the same line break as the scalar search across block edges (" + encodingName + ")");
+    ExpectSelfTest(run, countsMatch, "CountBareLineBreaks counts the bare line breaks across block edges (" + encodingName + ")");
+    ExpectSelfTest(run, conversionsMatch, "ConvertToCRLF matches the reference conversion across block edges (" + encodingName + ")");
+}
+
+// structure to hold a UTF-8 sequence and whether it is valid
+struct UTF8TestCase
+{
+    const char* text;
+    bool valid;
+};
+
+const UTF8TestCase UTF8_TEST_CASES[] =
+{
+    { "plain", true },
+    { "\xc3\xa9", true },
+    { "\xe2\x82\xac", true },
+    { "\xf0\x9f\x98\x80", true },
+    { "\xf4\x8f\xbf\xbf", true },
+    { "\xc0\xaf", false },
+    { "\xc1\xbf", false },
+    { "\xe0\x80\xaf", false },
+    { "\xf0\x80\x80\xaf", false },
+    { "\xed\xa0\x80", false },
+    { "\xed\xbf\xbf", false },
+    { "\xf4\x90\x80\x80", false },
+    { "\xf8\x88\x80\x80\x80", false },
+    { "\xff", false },
+    { "\x80", false },
+    { "\xc3", false },
+    { "\xe2\x82", false },
+    { "\xf0\x9f\x98", false },
+    { "\xe2\x82" "x", false }
+};
+
+// structure to hold a UTF-16 sequence and whether it is valid
+struct UTF16TestCase
+{
+    char16_t units[3];
+    size_t count;
+    bool valid;
+};
+
+const UTF16TestCase UTF16_TEST_CASES[] =
+{
+    { { 0x0041 }, 1, true },
+    { { 0xD83D, 0xDE00 }, 2, true },
+    { { 0xDBFF, 0xDFFF }, 2, true },
+    { { 0xD83D }, 1, false },
+    { { 0xDE00 }, 1, false },
+    { { 0xDE00, 0xD83D }, 2, false },
+    { { 0xD83D, 0x0041 }, 2, false },
+    { { 0xD83D, 0xD83D, 0xDE00 }, 3, false }
+};
+
+// function to check the line break kernels and the encoding validation, every encoding case is placed before and across the first block edges
+void RunTextScanSelfTests(SelfTestRun& run)
+{
+    CheckLineBreakKernels<char>(run, "bytes");
+    CheckLineBreakKernels<char16_t>(run, "UTF-16");
+
+    const size_t prefixLengths[] = { 0, 7, 8, 15, 16, 31 };
+    for (const UTF8TestCase& testCase : UTF8_TEST_CASES)
+    {
+        bool matches = true;
+        for (size_t prefixLength : prefixLengths)
+        {
+            std::string text = std::string(prefixLength, 'a') + testCase.text + "tail";
+            bool isASCII = false;
+            matches = matches && IsValidUTF8(text.data(), text.data() + text.size(), isASCII) == testCase.valid;
+            if (testCase.valid)
+            {
+                // the sequence also has to be judged alone, where it is cut off by the end of the text
+                std::string sequence = std::string(prefixLength, 'a') + testCase.text;
+                matches = matches && IsValidUTF8(sequence.data(), sequence.data() + sequence.size(), isASCII) && isASCII == (strcmp(testCase.text, "plain") == 0);
+            }
+        }
+        std::string bytes;
+        for (const char* c = testCase.text; *c != '\0'; ++c)
+        {
+            const char* digits = "0123456789abcdef";
+            bytes += digits[static_cast<unsigned char>(*c) >> 4];
+            bytes += digits[static_cast<unsigned char>(*c) & 0xF];
+        }
+        ExpectSelfTest(run, matches, "UTF-8 bytes " + bytes + (testCase.valid ? " are accepted" : " are rejected"));
+    }
+
+    for (size_t i = 0; i < sizeof(UTF16_TEST_CASES) / sizeof(UTF16_TEST_CASES[0]); ++i)
+    {
+        const UTF16TestCase& testCase = UTF16_TEST_CASES[i];
+        bool matches = true;
+        for (size_t prefixLength : prefixLengths)
+        {
+            std::u16string text = std::u16string(prefixLength, u'a') + std::u16string(testCase.units, testCase.count);
+            matches = matches && IsValidUTF16(text.data(), text.data() + text.size()) == testCase.valid;
+            text += u"tail";
+            matches = matches && IsValidUTF16(text.data(), text.data() + text.size()) == testCase.valid;
+        }
+        ExpectSelfTest(run, matches, "UTF-16 case " + std::to_string(i) + (testCase.valid ? " is accepted" : " is rejected"));
+    }
+}
+
+
+//
+//
+//
+// ARCHIVES
+//
+//
+//
+
+
+
+// function to write an archive for a self-test and validate its header, returning the problem found, empty for a valid archive
+std::wstring ValidateSelfTestArchive(const std::string& archive)
+{
+    std::wstring filePath = GetSelfTestFilePath("archive.sga");
+    if (!WriteWholeFile(filePath, nullptr, 0, archive.data(), archive.size()))
+    {
+        return L"the archive could not be written";
+    }
+
+    std::wstring problem;
+    std::string headerDigest;
+    if (ValidateSgaArchive(filePath.c_str(), problem, headerDigest) && headerDigest.empty())
+    {
+        problem = L"no header digest";
+    }
+    DeletePortableFile(filePath.c_str());
+    return problem;
+}
+
+// function to write an archive for a self-test and verify its stored data against the preamble checksums, returning the problem found, empty for an intact archive
+std::wstring VerifySelfTestArchiveContents(const std::string& archive)
+{
+    std::wstring filePath = GetSelfTestFilePath("contents.sga");
+    if (!WriteWholeFile(filePath, nullptr, 0, archive.data(), archive.size()))
+    {
+        return L"the archive could not be written";
+    }
+
+    std::wstring problem;
+    VerifySgaArchiveContents(filePath.c_str(), problem);
+    DeletePortableFile(filePath.c_str());
+    return problem;
+}
+
+// function to check that a built archive validates and verifies, and that truncating it, corrupting its tables or its payload is reported as the matching problem
+void RunArchiveSelfTests(SelfTestRun& run)
+{
+    const unsigned int fileCount = 4;
+    std::string archive = BuildSgaArchive("SelfTest", 64 * 1024, fileCount, 1);
+    ExpectSelfTest(run, ValidateSelfTestArchive(archive).empty(), "a version 5 archive passes validation");
+
+    ExpectSelfTest(run, ValidateSelfTestArchive(archive.substr(0, 100)) == L"truncated header", "an archive cut off in its header is reported");
+    ExpectSelfTest(run, ValidateSelfTestArchive(archive.substr(0, archive.size() - 1)) == L"file data extends beyond the end of the archive, it is likely truncated", "an archive cut off in its payload is reported");
+
+    std::string corrupted = archive;
+    WriteLittleEndian32(corrupted, 172, static_cast<uint32_t>(archive.size()));
+    ExpectSelfTest(run, ValidateSelfTestArchive(corrupted) == L"table of contents extends beyond the end of the file", "a table of contents running past the end of the file is reported");
+
+    // the folder table offset is stored in the data header, which directly follows the version 5 header
+    corrupted = archive;
+    const unsigned char* dataHeader = reinterpret_cast<const unsigned char*>(corrupted.data()) + SGA_HEADER_SIZE_V5;
+    size_t folderRecord = SGA_HEADER_SIZE_V5 + ReadLittleEndian32(dataHeader + 6);
+    WriteLittleEndian16(corrupted, folderRecord + 10, fileCount + 1);
+    ExpectSelfTest(run, ValidateSelfTestArchive(corrupted) == L"corrupt folder table", "a folder indexing past the file table is reported");
+
+    // files of 3 MiB straddle the verification chunks, so the checksum of the second file is combined from two chunks
+    std::string largeArchive = BuildSgaArchive("SelfTest", 9 * 1024 * 1024, 3, 2);
+    ExpectSelfTest(run, VerifySelfTestArchiveContents(largeArchive).empty(), "the stored data of an intact archive matches its checksums");
+
+    const unsigned char* largeData = reinterpret_cast<const unsigned char*>(largeArchive.data());
+    size_t fileRecord = SGA_HEADER_SIZE_V5 + ReadLittleEndian32(largeData + SGA_HEADER_SIZE_V5 + 12) + SGA_FILE_ENTRY_SIZE_V5;
+    size_t secondFileData = ReadLittleEndian32(largeData + 176) + ReadLittleEndian32(largeData + fileRecord + 4);
+    largeArchive[secondFileData + ReadLittleEndian32(largeData + fileRecord + 8) / 2] ^= 0x01;
+    ExpectSelfTest(run, VerifySelfTestArchiveContents(largeArchive) == L"1 stored file(s) do not match their checksum, the first is file1.dat", "a payload byte that no longer matches its preamble checksum is reported");
+}
+
+
+//
+//
+//
+// PROCESSES
+//
+//
+//
+
+
+
+// function to get the process identifier of the launcher itself
+unsigned long GetSelfTestProcessId()
+{
+#if BOOST_OS_WINDOWS
+    return GetCurrentProcessId();
+#else
+    return static_cast<unsigned long>(getpid());
+#endif
+}
+
+// function to check that the command line of the launcher itself is read, the self-tests only run when it holds -selftest
+void RunCommandLineSelfTests(SelfTestRun& run)
+{
+    std::wstring commandLine;
+    bool read = ReadProcessCommandLine(GetSelfTestProcessId(), commandLine);
+    ExpectSelfTest(run, read, "reading the launcher's own command line");
+    ExpectSelfTest(run, commandLine.find(L"-selftest") != std::wstring::npos, "the launcher's own command line holds -selftest");
+    ExpectSelfTest(run, GetCommandLineOfProcess(GetSelfTestProcessId()) == WStringToString(commandLine), "GetCommandLineOfProcess returns the same command line");
+
+    // process 0 is the idle process on Windows and does not exist on Linux, its command line can never be read
+    ExpectSelfTest(run, !ReadProcessCommandLine(0, commandLine) && commandLine.empty(), "reading the command line of process 0 fails");
+}
+
+// function to check that a second guard of the same name is refused while the first is held, and acquired once it is released
+void RunSingleInstanceSelfTests(SelfTestRun& run)
+{
+    // launchers are guarded by the name of their executable, so one running alongside the self-tests is never refused
+    std::string instanceName = "SelfTest";
+    {
+        SingleInstanceGuard first(instanceName);
+        ExpectSelfTest(run, first.acquired, "the first single instance guard is acquired");
+        SingleInstanceGuard second(instanceName);
+        ExpectSelfTest(run, !second.acquired, "a second single instance guard of the same name is refused");
+    }
+    SingleInstanceGuard again(instanceName);
+    ExpectSelfTest(run, again.acquired, "a single instance guard is acquired again once the first is released");
+}
+
+
+
+//
+//
+//
+// TOPOLOGY
+//
+//
+//
+
+
+
+// structure to hold a captured sysfs cpu directory and the topology expected from it
+struct TopologyTestFixture
+{
+    const char* name;
+    unsigned int physicalCores;
+    unsigned int logicalProcessors;
+    unsigned int lastLevelCaches;
+    bool smt;
+    bool hybrid;
+    unsigned long long fastCoreMask;
+};
+
+// hybrid: two performance cores with two threads each, two efficiency cores of which one is offline
+// smt: four cores with two threads each and no capacities, the siblings numbered apart as on Intel processors
+// partial: four cores where the kernel reports no capacity for the last core, so the cores cannot be ranked
+const TopologyTestFixture TOPOLOGY_TEST_FIXTURES[] =
+{
+    { "hybrid", 3, 5, 1, true, true, 0xf },
+    { "smt", 4, 8, 1, true, false, 0 },
+    { "partial", 4, 4, 1, false, false, 0 }
+};
+
+// function to check the topology read from each captured sysfs cpu directory in the fixtures directory
+void RunTopologySelfTests(SelfTestRun& run, const std::wstring& fixturesDirectory)
+{
+    for (const TopologyTestFixture& fixture : TOPOLOGY_TEST_FIXTURES)
+    {
+        std::string name = std::string("topology of the ") + fixture.name + " layout";
+        CpuTopology topology;
+        if (!ReadCpuTopologyFromSysfs((boost::filesystem::path(fixturesDirectory) / "sysfs" / fixture.name).string(), topology))
+        {
+            ExpectSelfTest(run, false, "reading the " + name);
+            continue;
+        }
+        ExpectSelfTest(run, topology.physicalCores == fixture.physicalCores, name + ": physical cores");
+        ExpectSelfTest(run, topology.logicalProcessors == fixture.logicalProcessors, name + ": logical processors");
+        ExpectSelfTest(run, topology.lastLevelCaches == fixture.lastLevelCaches, name + ": last level caches");
+        ExpectSelfTest(run, topology.smt == fixture.smt, name + ": SMT");
+        ExpectSelfTest(run, topology.hybrid == fixture.hybrid, name + ": hybrid");
+        ExpectSelfTest(run, GetFastCoreAffinityMask(topology, 0) == fixture.fastCoreMask, name + ": fast core affinity mask");
+    }
+}
+
+
+
+//
+//
+//
+// TRACE
+//
+//
+//
+
+
+
+// function to skip the whitespace JSON allows between tokens
+void SkipJsonWhitespace(const std::string& text, size_t& pos)
+{
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+    {
+        ++pos;
+    }
+}
+
+// function to check a JSON string at the position, control characters have to be escaped and escapes have to be complete
+bool CheckJsonString(const std::string& text, size_t& pos)
+{
+    if (pos >= text.size() || text[pos] != '"')
+    {
+        return false;
+    }
+    for (++pos; pos < text.size(); ++pos)
+    {
+        unsigned char c = static_cast<unsigned char>(text[pos]);
+        if (c == '"')
+        {
+            ++pos;
+            return true;
+        }
+        if (c < 0x20)
+        {
+            return false;
+        }
+        if (c == '\\')
+        {
+            if (++pos >= text.size())
+            {
+                return false;
+            }
+            if (text[pos] == 'u')
+            {
+                if (pos + 4 >= text.size() || text.find_first_not_of("0123456789abcdefABCDEF", pos + 1) < pos + 5)
+                {
+                    return false;
+                }
+                pos += 4;
+            }
+            else if (std::string("\"\\/bfnrt").find(text[pos]) == std::string::npos)
+            {
+                return false;
+            }
+        }
+    }
+    return false;
+}
+
+// function to check a JSON number at the position
+bool CheckJsonNumber(const std::string& text, size_t& pos)
+{
+    size_t start = pos;
+    if (pos < text.size() && text[pos] == '-')
+    {
+        ++pos;
+    }
+    size_t digits = pos;
+    while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9')
+    {
+        ++pos;
+    }
+    if (pos == digits || (text[digits] == '0' && pos - digits > 1))
+    {
+        pos = start;
+        return false;
+    }
+    return true;
+}
+
+// function to check the JSON value at the position, by recursive descent into objects and arrays
+bool CheckJsonValue(const std::string& text, size_t& pos)
+{
+    SkipJsonWhitespace(text, pos);
+    if (pos >= text.size())
+    {
+        return false;
+    }
+
+    char opening = text[pos];
+    if (opening == '"')
+    {
+        return CheckJsonString(text, pos);
+    }
+    if (opening == '{' || opening == '[')
+    {
+        char closing = opening == '{' ? '}' : ']';
+        ++pos;
+        SkipJsonWhitespace(text, pos);
+        if (pos < text.size() && text[pos] == closing)
+        {
+            ++pos;
+            return true;
+        }
+        while (true)
+        {
+            if (opening == '{')
+            {
+                SkipJsonWhitespace(text, pos);
+                if (!CheckJsonString(text, pos))
+                {
+                    return false;
+                }
+                SkipJsonWhitespace(text, pos);
+                if (pos >= text.size() || text[pos++] != ':')
+                {
+                    return false;
+                }
+            }
+            if (!CheckJsonValue(text, pos))
+            {
+                return false;
+            }
+            SkipJsonWhitespace(text, pos);
+            if (pos >= text.size())
+            {
+                return false;
+            }
+            if (text[pos] == closing)
+            {
+                ++pos;
+                return true;
+            }
+            if (text[pos++] != ',')
+            {
+                return false;
+            }
+        }
+    }
+    for (const char* literal : { "true", "false", "null" })
+    {
+        if (text.compare(pos, std::strlen(literal), literal) == 0)
+        {
+            pos += std::strlen(literal);
+            return true;
+        }
+    }
+    return CheckJsonNumber(text, pos);
+}
+
+// function to check that a whole text is a single JSON value
+bool IsValidJson(const std::string& text)
+{
+    size_t pos = 0;
+    if (!CheckJsonValue(text, pos))
+    {
+        return false;
+    }
+    SkipJsonWhitespace(text, pos);
+    return pos == text.size();
+}
+
+// function to check that the trace written for spans with text needing escapes, recorded on the main thread and a worker, is valid JSON
+void RunTraceSelfTests(SelfTestRun& run)
+{
+    ExpectSelfTest(run, IsValidJson("{\"a\":[1,-2,\"\\u00e9\\n\",true,null,{}]}") && !IsValidJson("{\"a\":[1,],}") && !IsValidJson("\"\x01\""), "the JSON checker tells valid and invalid JSON apart");
+
+    // the trace log of a launcher started with -trace is set aside and restored, so its own trace is still written
+    bool wasEnabled = traceLog.enabled;
+    std::string previousFilePath = traceLog.filePath;
+    std::vector<TraceEvent> previousEvents;
+    {
+        std::lock_guard<std::mutex> lock(traceLog.mutex);
+        previousEvents.swap(traceLog.events);
+    }
+    std::wstring filePath = GetSelfTestFilePath("trace.json");
+    traceLog.filePath = boost::filesystem::path(filePath).string();
+    traceLog.enabled = true;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    RecordTraceEvent("Span \"quoted\" \\ escaped", std::string("C:\\Mods\\\"file\".ucs\n\t\r\x01\x1f \xc3\xa9"), now, now);
+    RecordTraceEvent("Span without detail", std::string(), now, now);
+    std::thread worker([]()
+        {
+            TraceSpan span("Worker span", std::wstring(L"GameAssets\\Locale\\English\\\u00e9.ucs"));
+        });
+    worker.join();
+    WriteTrace();
+
+    std::ifstream traceFile(traceLog.filePath, std::ios::binary);
+    std::string trace((std::istreambuf_iterator<char>(traceFile)), std::istreambuf_iterator<char>());
+    traceFile.close();
+    ExpectSelfTest(run, !trace.empty(), "writing the trace file");
+    ExpectSelfTest(run, IsValidJson(trace), "the trace file is valid JSON");
+    ExpectSelfTest(run, trace.find("C:\\\\Mods\\\\\\\"file\\\".ucs\\n\\t\\r\\u0001\\u001f") != std::string::npos, "the trace file escapes the detail of a span");
+    DeletePortableFile(filePath.c_str());
+
+    {
+        std::lock_guard<std::mutex> lock(traceLog.mutex);
+        traceLog.events.swap(previousEvents);
+    }
+    traceLog.filePath = previousFilePath;
+    traceLog.enabled = wasEnabled;
+}
+
+
+
+//
+//
+//
+// SELF-TEST RUN
+//
+//
+//
+
+
+
+// function to run every self-test, returning the exit code
+// the topology fixtures are only shipped with the source, so they are skipped when the default directory does not exist
+int RunSelfTests(const std::wstring& fixturesDirectory, bool fixturesRequired)
+{
+    SelfTestRun run;
+    RunHashSelfTests(run);
+    RunTextScanSelfTests(run);
+    RunArchiveSelfTests(run);
+    RunCommandLineSelfTests(run);
+    RunSingleInstanceSelfTests(run);
+    RunTraceSelfTests(run);
+    if (fixturesRequired || boost::filesystem::is_directory(fixturesDirectory))
+    {
+        RunTopologySelfTests(run, fixturesDirectory);
+    }
+    else
+    {
+        std::wcout << L"Fixtures directory " << fixturesDirectory << L" not found, topology self-tests skipped." << std::endl;
+    }
+
+    std::cout << "Self-tests: " << run.passed << " passed, " << run.failed << " failed." << std::endl;
+    return run.failed == 0 ? 0 : 1;
+}
\ No newline at end of file
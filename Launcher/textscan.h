@@ -0,0 +1,291 @@
+// header for the text scanning kernels used by the line ending and encoding checks, vectorized with SSE2 where available and scalar otherwise
+
+#pragma once
+
+// standard library headers
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+// SSE2 is part of every x64 target and the default for 32-bit MSVC builds
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTSCAN_SSE2 1
+#include <emmintrin.h>
+#else
+#define TEXTSCAN_SSE2 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+
+//
+//
+//
+// VECTOR HELPERS
+//
+//
+//
+
+
+
+#if TEXTSCAN_SSE2
+// function to get the index of the lowest set bit of a non-zero mask
+unsigned int LowestSetBit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned int>(index);
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+// function to get a mask of the CR and LF bytes in a 16 byte block
+unsigned int LineBreakMask(const char* block)
+{
+    __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    __m128i matches = _mm_or_si128(_mm_cmpeq_epi8(data, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(data, _mm_set1_epi8('\n')));
+    return static_cast<unsigned int>(_mm_movemask_epi8(matches));
+}
+
+// function to get a byte mask of the CR and LF code units in a block of 8 UTF-16 code units
+unsigned int LineBreakMask(const char16_t* block)
+{
+    __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    __m128i matches = _mm_or_si128(_mm_cmpeq_epi16(data, _mm_set1_epi16(0x000D)), _mm_cmpeq_epi16(data, _mm_set1_epi16(0x000A)));
+    return static_cast<unsigned int>(_mm_movemask_epi8(matches));
+}
+#endif
+
+
+
+//
+//
+//
+// LINE BREAKS
+//
+//
+//
+
+
+
+// function to find the first CR or LF, one code unit at a time
+template <typename CharType>
+const CharType* FindLineBreakScalar(const CharType* begin, const CharType* end)
+{
+    for (const CharType* current = begin; current < end; ++current)
+    {
+        if (*current == CharType('\r') || *current == CharType('\n'))
+        {
+            return current;
+        }
+    }
+    return end;
+}
+
+// function to find the first CR or LF, skipping 16 bytes at a time while a block holds neither
+template <typename CharType>
+const CharType* FindLineBreak(const CharType* begin, const CharType* end)
+{
+#if TEXTSCAN_SSE2
+    const size_t unitsPerBlock = 16 / sizeof(CharType);
+    const CharType* current = begin;
+    while (static_cast<size_t>(end - current) >= unitsPerBlock)
+    {
+        unsigned int mask = LineBreakMask(current);
+        if (mask != 0)
+        {
+            return current + LowestSetBit(mask) / sizeof(CharType);
+        }
+        current += unitsPerBlock;
+    }
+    return FindLineBreakScalar(current, end);
+#else
+    return FindLineBreakScalar(begin, end);
+#endif
+}
+
+// function to count the CR and LF characters that are not part of a CRLF pair
+template <typename CharType>
+size_t CountBareLineBreaks(const CharType* begin, const CharType* end)
+{
+    size_t bareBreaks = 0;
+    const CharType* current = FindLineBreak(begin, end);
+    while (current < end)
+    {
+        if (*current == CharType('\r') && current + 1 < end && current[1] == CharType('\n'))
+        {
+            current += 2;
+        }
+        else
+        {
+            ++bareBreaks;
+            ++current;
+        }
+        current = FindLineBreak(current, end);
+    }
+    return bareBreaks;
+}
+
+// function to convert every bare CR and LF to CRLF, sizing the output up front and copying the runs between line breaks in blocks
+template <typename CharType>
+std::basic_string<CharType> ConvertToCRLF(const CharType* begin, const CharType* end, size_t bareBreaks)
+{
+    std::basic_string<CharType> convertedContent(static_cast<size_t>(end - begin) + bareBreaks, CharType(0));
+    CharType* output = &convertedContent[0];
+
+    const CharType* current = begin;
+    while (current < end)
+    {
+        const CharType* lineBreak = FindLineBreak(current, end);
+        size_t runLength = static_cast<size_t>(lineBreak - current);
+        memcpy(output, current, runLength * sizeof(CharType));
+        output += runLength;
+        if (lineBreak == end)
+        {
+            break;
+        }
+
+        *output++ = CharType('\r');
+        *output++ = CharType('\n');
+        current = lineBreak + ((*lineBreak == CharType('\r') && lineBreak + 1 < end && lineBreak[1] == CharType('\n')) ? 2 : 1);
+    }
+
+    convertedContent.resize(static_cast<size_t>(output - convertedContent.data()));
+    return convertedContent;
+}
+
+
+
+//
+//
+//
+// ENCODING VALIDATION
+//
+//
+//
+
+
+
+// function to validate UTF-8, rejecting overlong forms, surrogates and code points above U+10FFFF, and to report whether the text is plain ASCII
+bool IsValidUTF8(const char* begin, const char* end, bool& isASCII)
+{
+    const unsigned char* current = reinterpret_cast<const unsigned char*>(begin);
+    const unsigned char* last = reinterpret_cast<const unsigned char*>(end);
+    isASCII = true;
+
+    while (current < last)
+    {
+#if TEXTSCAN_SSE2
+        // skip blocks of 16 ASCII bytes, the top bit of every byte is clear
+        while (last - current >= 16 && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(current))) == 0)
+        {
+            current += 16;
+        }
+        if (current >= last)
+        {
+            break;
+        }
+#endif
+        unsigned char lead = *current;
+        if (lead < 0x80)
+        {
+            ++current;
+            continue;
+        }
+        isASCII = false;
+
+        size_t length;
+        uint32_t codePoint;
+        uint32_t minimum;
+        if ((lead & 0xE0) == 0xC0)
+        {
+            length = 2;
+            codePoint = lead & 0x1F;
+            minimum = 0x80;
+        }
+        else if ((lead & 0xF0) == 0xE0)
+        {
+            length = 3;
+            codePoint = lead & 0x0F;
+            minimum = 0x800;
+        }
+        else if ((lead & 0xF8) == 0xF0)
+        {
+            length = 4;
+            codePoint = lead & 0x07;
+            minimum = 0x10000;
+        }
+        else
+        {
+            return false;
+        }
+
+        if (static_cast<size_t>(last - current) < length)
+        {
+            return false;
+        }
+        for (size_t i = 1; i < length; ++i)
+        {
+            if ((current[i] & 0xC0) != 0x80)
+            {
+                return false;
+            }
+            codePoint = (codePoint << 6) | (current[i] & 0x3F);
+        }
+        if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        {
+            return false;
+        }
+        current += length;
+    }
+    return true;
+}
+
+// function to validate UTF-16, every high surrogate has to be followed by a low surrogate and no low surrogate may stand alone
+bool IsValidUTF16(const char16_t* begin, const char16_t* end)
+{
+    const char16_t* current = begin;
+    while (current < end)
+    {
+#if TEXTSCAN_SSE2
+        // skip blocks of 8 code units without any surrogate, (unit & 0xF800) == 0xD800 holds for every surrogate
+        while (end - current >= 8)
+        {
+            __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+            __m128i surrogates = _mm_cmpeq_epi16(_mm_and_si128(data, _mm_set1_epi16(static_cast<short>(0xF800))), _mm_set1_epi16(static_cast<short>(0xD800)));
+            if (_mm_movemask_epi8(surrogates) != 0)
+            {
+                break;
+            }
+            current += 8;
+        }
+        if (current >= end)
+        {
+            break;
+        }
+#endif
+        char16_t unit = *current;
+        if (unit >= 0xD800 && unit <= 0xDBFF)
+        {
+            if (current + 1 >= end || current[1] < 0xDC00 || current[1] > 0xDFFF)
+            {
+                return false;
+            }
+            current += 2;
+        }
+        else if (unit >= 0xDC00 && unit <= 0xDFFF)
+        {
+            return false;
+        }
+        else
+        {
+            ++current;
+        }
+    }
+    return true;
+}
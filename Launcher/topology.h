@@ -0,0 +1,337 @@
+// header for probing the processor topology, used to decide which game files are needed and which cores the game runs on
+
+#pragma once
+
+#define CPU_SYSFS_ROOT "/sys/devices/system/cpu" // directory the Linux kernel describes the processors in
+
+// standard library headers
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <fstream>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+
+// boost headers
+#include <boost/predef/os.h>
+#include <boost/filesystem.hpp>
+
+// launcher headers
+#include "trace.h"
+
+// platform headers
+#if BOOST_OS_WINDOWS
+#include <windows.h>
+#endif
+
+// structure to hold one physical core and the logical processors it runs
+struct CpuCore
+{
+    unsigned short group = 0; // processor group, always 0 on Linux
+    unsigned long long mask = 0; // logical processors of the core within its group
+    unsigned int logicalProcessors = 0;
+    unsigned char efficiencyClass = 0; // higher is faster, all cores share one class on processors without different core types
+};
+
+// structure to hold the processor topology of the system
+struct CpuTopology
+{
+    unsigned int logicalProcessors = 0; // across every processor group
+    unsigned int physicalCores = 0;
+    unsigned int processorGroups = 0;
+    unsigned int numaNodes = 0;
+    unsigned int lastLevelCaches = 0; // number of separate caches of the highest level, each shared by a cluster of cores
+    unsigned char highestEfficiencyClass = 0;
+    bool smt = false; // at least one core runs more than one logical processor
+    bool hybrid = false; // the cores do not all share one efficiency class
+    std::vector<CpuCore> cores;
+};
+
+// function to count the bits set in a processor mask
+unsigned int CountMaskBits(unsigned long long mask)
+{
+    unsigned int count = 0;
+    for (; mask != 0; mask &= mask - 1)
+    {
+        ++count;
+    }
+    return count;
+}
+
+// function to derive the totals of a topology from its list of cores
+void SummarizeCpuTopology(CpuTopology& topology)
+{
+    topology.physicalCores = static_cast<unsigned int>(topology.cores.size());
+    topology.logicalProcessors = 0;
+    topology.smt = false;
+    topology.hybrid = false;
+    topology.highestEfficiencyClass = 0;
+
+    for (const auto& core : topology.cores)
+    {
+        topology.logicalProcessors += core.logicalProcessors;
+        topology.smt = topology.smt || core.logicalProcessors > 1;
+        if (core.efficiencyClass > topology.highestEfficiencyClass)
+        {
+            topology.highestEfficiencyClass = core.efficiencyClass;
+        }
+    }
+    for (const auto& core : topology.cores)
+    {
+        topology.hybrid = topology.hybrid || core.efficiencyClass != topology.highestEfficiencyClass;
+    }
+}
+
+// function to get the logical processors of the fastest cores in a processor group, 0 when every core is equally fast and no restriction is needed
+unsigned long long GetFastCoreAffinityMask(const CpuTopology& topology, unsigned short group)
+{
+    if (!topology.hybrid)
+    {
+        return 0;
+    }
+
+    unsigned long long mask = 0;
+    for (const auto& core : topology.cores)
+    {
+        if (core.group == group && core.efficiencyClass == topology.highestEfficiencyClass)
+        {
+            mask |= core.mask;
+        }
+    }
+    return mask;
+}
+
+
+
+//
+//
+//
+// LINUX SYSFS
+//
+//
+//
+
+
+
+// function to read the first line of a small sysfs file
+bool ReadSysfsValue(const boost::filesystem::path& path, std::string& value)
+{
+    std::ifstream file(path.string());
+    if (!file.is_open() || !std::getline(file, value))
+    {
+        return false;
+    }
+    while (!value.empty() && (value.back() == '\n' || value.back() == ' '))
+    {
+        value.pop_back();
+    }
+    return true;
+}
+
+// function to parse a processor list such as 0-3,8,10-11 into a mask, processors beyond the width of the mask are ignored
+unsigned long long ParseCpuList(const std::string& list)
+{
+    unsigned long long mask = 0;
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos)
+        {
+            end = list.size();
+        }
+        std::string range = list.substr(pos, end - pos);
+        size_t dash = range.find('-');
+        unsigned long first = std::strtoul(range.c_str(), nullptr, 10);
+        unsigned long last = (dash == std::string::npos) ? first : std::strtoul(range.c_str() + dash + 1, nullptr, 10);
+        for (unsigned long cpu = first; cpu <= last && cpu < 64; ++cpu)
+        {
+            mask |= 1ULL << cpu;
+        }
+        pos = end + 1;
+    }
+    return mask;
+}
+
+// function to read the processor topology from a sysfs cpu directory, the root is a parameter so captured copies of it can be read as well
+// cores are told apart by their sibling lists, efficiency classes come from cpu_capacity where the kernel provides it
+bool ReadCpuTopologyFromSysfs(const std::string& cpuRoot, CpuTopology& topology)
+{
+    topology = CpuTopology();
+    boost::system::error_code ec;
+    boost::filesystem::directory_iterator it(boost::filesystem::path(cpuRoot), ec);
+    if (ec)
+    {
+        return false;
+    }
+
+    std::map<std::string, CpuCore> coresBySiblings;
+    std::map<std::string, unsigned int> capacityBySiblings;
+    std::set<std::string> numaNodes;
+    std::map<int, std::set<std::string>> cachesByLevel;
+
+    for (; it != boost::filesystem::directory_iterator(); it.increment(ec))
+    {
+        if (ec)
+        {
+            break;
+        }
+        std::string name = it->path().filename().string();
+        if (name.size() < 4 || name.compare(0, 3, "cpu") != 0 || name.find_first_not_of("0123456789", 3) != std::string::npos)
+        {
+            continue;
+        }
+
+        // offline processors keep their directory but lose their topology, the boot processor has no online file at all
+        std::string online;
+        if (ReadSysfsValue(it->path() / "online", online) && online == "0")
+        {
+            continue;
+        }
+        std::string siblings;
+        if (!ReadSysfsValue(it->path() / "topology" / "thread_siblings_list", siblings))
+        {
+            continue;
+        }
+
+        CpuCore& core = coresBySiblings[siblings];
+        core.mask = ParseCpuList(siblings);
+        core.logicalProcessors += 1;
+
+        std::string capacity;
+        if (ReadSysfsValue(it->path() / "cpu_capacity", capacity))
+        {
+            capacityBySiblings[siblings] = static_cast<unsigned int>(std::strtoul(capacity.c_str(), nullptr, 10));
+        }
+
+        for (boost::filesystem::directory_iterator entry(it->path(), ec); !ec && entry != boost::filesystem::directory_iterator(); entry.increment(ec))
+        {
+            std::string entryName = entry->path().filename().string();
+            if (entryName.size() > 4 && entryName.compare(0, 4, "node") == 0)
+            {
+                numaNodes.insert(entryName);
+            }
+        }
+
+        for (boost::filesystem::directory_iterator index(it->path() / "cache", ec); !ec && index != boost::filesystem::directory_iterator(); index.increment(ec))
+        {
+            std::string level;
+            std::string sharedList;
+            if (ReadSysfsValue(index->path() / "level", level) && ReadSysfsValue(index->path() / "shared_cpu_list", sharedList))
+            {
+                cachesByLevel[std::atoi(level.c_str())].insert(sharedList);
+            }
+        }
+        ec.clear();
+    }
+
+    if (coresBySiblings.empty())
+    {
+        return false;
+    }
+
+    // distinct capacities are ranked, so the slowest cores get class 0 as they do on Windows
+    // a core without a capacity cannot be ranked against the others, so the classes are only assigned when every core has one
+    std::set<unsigned int> capacities;
+    for (const auto& capacity : capacityBySiblings)
+    {
+        capacities.insert(capacity.second);
+    }
+    bool ranked = capacityBySiblings.size() == coresBySiblings.size();
+    for (auto& entry : coresBySiblings)
+    {
+        if (ranked)
+        {
+            entry.second.efficiencyClass = static_cast<unsigned char>(std::distance(capacities.begin(), capacities.find(capacityBySiblings[entry.first])));
+        }
+        topology.cores.push_back(entry.second);
+    }
+
+    topology.processorGroups = 1;
+    topology.numaNodes = numaNodes.empty() ? 1 : static_cast<unsigned int>(numaNodes.size());
+    topology.lastLevelCaches = cachesByLevel.empty() ? 0 : static_cast<unsigned int>(cachesByLevel.rbegin()->second.size());
+    SummarizeCpuTopology(topology);
+    return true;
+}
+
+
+
+//
+//
+//
+// PLATFORM PROBE
+//
+//
+//
+
+
+
+// function to probe the processor topology of the running system
+bool ProbeCpuTopology(CpuTopology& topology)
+{
+    TRACE_SCOPE("ProbeCpuTopology");
+#if BOOST_OS_WINDOWS
+    // the processors of the current group are kept as the count when the detailed information is unavailable
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    topology = CpuTopology();
+    topology.logicalProcessors = systemInfo.dwNumberOfProcessors;
+    topology.processorGroups = 1;
+
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, NULL, &length);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || length == 0)
+    {
+        return false;
+    }
+
+    std::vector<unsigned char> buffer(length);
+    if (!GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length))
+    {
+        return false;
+    }
+
+    std::map<int, unsigned int> cachesByLevel;
+    for (DWORD offset = 0; offset < length;)
+    {
+        const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+        switch (info->Relationship)
+        {
+        case RelationProcessorCore:
+        {
+            CpuCore core;
+            core.group = info->Processor.GroupMask[0].Group;
+            core.mask = info->Processor.GroupMask[0].Mask;
+            core.logicalProcessors = CountMaskBits(core.mask);
+            core.efficiencyClass = info->Processor.EfficiencyClass;
+            topology.cores.push_back(core);
+        }
+        break;
+
+        case RelationNumaNode:
+            ++topology.numaNodes;
+            break;
+
+        case RelationCache:
+            ++cachesByLevel[info->Cache.Level];
+            break;
+
+        case RelationGroup:
+            topology.processorGroups = info->Group.ActiveGroupCount;
+            break;
+
+        default:
+            break;
+        }
+        offset += info->Size;
+    }
+
+    topology.lastLevelCaches = cachesByLevel.empty() ? 0 : cachesByLevel.rbegin()->second;
+    SummarizeCpuTopology(topology);
+    return !topology.cores.empty();
+#else
+    return ReadCpuTopologyFromSysfs(CPU_SYSFS_ROOT, topology);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,224 @@
+// header for recording timed spans of the launcher's work and exporting them in the Chrome trace event format
+
+#pragma once
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(...) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(__VA_ARGS__) // records the enclosing scope as a span, costs a single flag check while tracing is off
+
+// standard library headers
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+
+// boost headers
+#include <boost/locale/encoding_utf.hpp>
+
+// structure to hold one finished span
+struct TraceEvent
+{
+    const char* name = nullptr;
+    std::string detail; // UTF-8, usually the file the span worked on
+    long long start = 0; // microseconds since the trace started
+    long long duration = 0;
+    unsigned int threadId = 0;
+};
+
+// structure to hold the spans recorded while the launcher runs with -trace
+struct TraceLog
+{
+    bool enabled = false; // only set before any worker thread starts
+    std::string filePath;
+    std::chrono::steady_clock::time_point origin;
+    std::chrono::steady_clock::time_point lastPhaseEnd;
+    std::vector<TraceEvent> events;
+    std::mutex mutex;
+    std::atomic<unsigned int> nextThreadId{ 1 };
+};
+
+// global trace log
+TraceLog traceLog;
+
+// function to get a small, stable number for the calling thread, the thread that starts the trace is number 1
+unsigned int GetTraceThreadId()
+{
+    thread_local unsigned int threadId = traceLog.nextThreadId++;
+    return threadId;
+}
+
+// function to add a finished span to the trace log
+void RecordTraceEvent(const char* name, std::string detail, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    TraceEvent event;
+    event.name = name;
+    event.detail = std::move(detail);
+    event.start = std::chrono::duration_cast<std::chrono::microseconds>(start - traceLog.origin).count();
+    event.duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    event.threadId = GetTraceThreadId();
+
+    std::lock_guard<std::mutex> lock(traceLog.mutex);
+    traceLog.events.push_back(std::move(event));
+}
+
+// function to escape text for a JSON string
+std::string EscapeJsonString(const std::string& text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        case '\r':
+            escaped += "\\r";
+            break;
+        case '\t':
+            escaped += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(c)));
+                escaped += code;
+            }
+            else
+            {
+                escaped += c;
+            }
+            break;
+        }
+    }
+    return escaped;
+}
+
+// function to write the recorded spans as a Chrome trace event file, which chrome://tracing and Perfetto open directly
+void WriteTrace()
+{
+    if (!traceLog.enabled)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(traceLog.mutex);
+    std::ofstream traceFile(traceLog.filePath, std::ios::binary | std::ios::trunc);
+    if (!traceFile.is_open())
+    {
+        return;
+    }
+
+    traceFile << "{\"traceEvents\":[\n";
+    for (const auto& event : traceLog.events)
+    {
+        traceFile << "{\"name\":\"" << EscapeJsonString(event.name) << "\",\"cat\":\"launcher\",\"ph\":\"X\",\"ts\":" << event.start << ",\"dur\":" << event.duration << ",\"pid\":1,\"tid\":" << event.threadId;
+        if (!event.detail.empty())
+        {
+            traceFile << ",\"args\":{\"detail\":\"" << EscapeJsonString(event.detail) << "\"}";
+        }
+        traceFile << "},\n";
+    }
+
+    // name the threads, so the main thread and the workers are told apart in the viewer
+    unsigned int threadCount = traceLog.nextThreadId.load() - 1;
+    for (unsigned int threadId = 1; threadId <= threadCount; ++threadId)
+    {
+        traceFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId << ",\"args\":{\"name\":\"" << (threadId == 1 ? std::string("main") : "worker " + std::to_string(threadId - 1)) << "\"}}" << (threadId < threadCount ? ",\n" : "\n");
+    }
+    traceFile << "],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+// function to start recording spans, the trace is written when the launcher exits, including through exit()
+void StartTrace(const std::string& filePath)
+{
+    traceLog.filePath = filePath;
+    traceLog.origin = std::chrono::steady_clock::now();
+    traceLog.lastPhaseEnd = traceLog.origin;
+    traceLog.enabled = true;
+    GetTraceThreadId();
+    std::atexit(WriteTrace);
+}
+
+// function to record a phase of sequential code on the main thread, spanning from the end of the previous phase until now
+void TracePhase(const char* name)
+{
+    if (!traceLog.enabled)
+    {
+        return;
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    RecordTraceEvent(name, std::string(), traceLog.lastPhaseEnd, now);
+    traceLog.lastPhaseEnd = now;
+}
+
+// structure to record the scope it lives in as a span, created through TRACE_SCOPE
+struct TraceSpan
+{
+    const char* name = nullptr;
+    std::string detail;
+    std::chrono::steady_clock::time_point start;
+
+    explicit TraceSpan(const char* spanName)
+    {
+        if (traceLog.enabled)
+        {
+            name = spanName;
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    TraceSpan(const char* spanName, const std::wstring& spanDetail)
+    {
+        if (traceLog.enabled)
+        {
+            name = spanName;
+            detail = boost::locale::conv::utf_to_utf<char>(spanDetail);
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    TraceSpan(const char* spanName, const wchar_t* spanDetail)
+    {
+        if (traceLog.enabled)
+        {
+            name = spanName;
+            detail = boost::locale::conv::utf_to_utf<char>(spanDetail);
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    TraceSpan(const char* spanName, const std::string& spanDetail)
+    {
+        if (traceLog.enabled)
+        {
+            name = spanName;
+            detail = spanDetail;
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (name != nullptr)
+        {
+            RecordTraceEvent(name, std::move(detail), start, std::chrono::steady_clock::now());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
\ No newline at end of file